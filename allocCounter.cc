@@ -0,0 +1,64 @@
+// allocCounter.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  The counting replacements for the global operator new and delete
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//    allocCounter.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "allocCounter.h"
+#include <cstdlib>
+#include <new>
+
+std::atomic<unsigned long> heapAllocations(0);
+
+// every allocation, array or not, goes through countedAllocation()
+static void * countedAllocation(size_t size) {
+    heapAllocations++;
+    void * memory = malloc(size ? size : 1);
+    if (memory == 0) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void * operator new(size_t size) {
+    return countedAllocation(size);
+}
+
+void * operator new[](size_t size) {
+    return countedAllocation(size);
+}
+
+void operator delete(void * memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void * memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void * memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void * memory, size_t) noexcept {
+    free(memory);
+}
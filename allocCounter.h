@@ -0,0 +1,36 @@
+// allocCounter.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Counts heap allocations, for the benchmarks and allocTest. Linking
+//  allocCounter.o replaces the global operator new and delete, so it
+//  is kept out of libunifont2things.
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//    allocCounter.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <atomic>
+
+// calls to operator new and new[] since the program started
+extern std::atomic<unsigned long> heapAllocations;
+
+#endif
@@ -0,0 +1,109 @@
+// allocTest.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Checks that once warmed up, rendering a message allocates nothing,
+//  through the arena, the glyph audio cache and the library's
+//  HellRenderer. Exits non-zero, naming the path, if any allocates.
+//
+//  Usage: make test
+//     or: ./allocTest font.hex
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//    allocTest.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "bitmap2waterfall.h"
+#include "allocCounter.h"
+#include "unifont2things.h"
+#include <cstdio>
+#include <functional>
+
+using namespace std;
+
+// the README's punctuation, escapes, CJK and a run of blanks
+static const char message[] =
+    "CQ CQ de VK5 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~ U+262F 漢字    ";
+
+// render is run once to warm up, then must not allocate at all
+static bool expectNoAllocations(const char * name,
+                                const std::function<void()> & render) {
+    render();
+    unsigned long before = heapAllocations;
+    render();
+    unsigned long allocations = heapAllocations - before;
+    printf("%s: %lu allocations once warmed up\n", name, allocations);
+    return allocations == 0;
+}
+
+int main (int argc, char * argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: allocTest font" << std::endl;
+        return 1;
+    }
+    std::map<int, Glyph*> glyphMap = load_font_file(argv[1]);
+    if (glyphMap.empty()) {
+        std::cerr << "No glyphs in " << argv[1] << std::endl;
+        return 1;
+    }
+
+    RenderContext context;
+    GlyphAudioCache cache;
+    unsigned long long checksum = 0;
+    bool passed = true;
+    passed = expectNoAllocations("renderGlyphCodeAudio", [&]() {
+            Utf8Tokenizer tokens(message);
+            int codepoint;
+            size_t length;
+            while (tokens.next(codepoint)) {
+                if (renderGlyphCodeAudio(glyphMap, codepoint, 0,
+                                         context, length) != 0) {
+                    checksum += length;
+                }
+            }
+        }) && passed;
+    passed = expectNoAllocations("renderGlyphCodeAudio, cached", [&]() {
+            Utf8Tokenizer tokens(message);
+            int codepoint;
+            size_t length;
+            while (tokens.next(codepoint)) {
+                if (renderGlyphCodeAudio(glyphMap, codepoint, &cache,
+                                         context, length) != 0) {
+                    checksum += length;
+                }
+            }
+        }) && passed;
+
+    unifont2things::HellRenderer renderer({argv[1]});
+    std::vector<int8_t> buffer(renderer.render(message, 0, 0));
+    passed = expectNoAllocations("HellRenderer::render", [&]() {
+            checksum += renderer.render(message, buffer.data(),
+                                        buffer.size());
+        }) && passed;
+
+    cleanUpGlyphMap(glyphMap);
+    if (checksum == 0) {
+        std::cerr << "No audio rendered from " << argv[1] << std::endl;
+        return 1;
+    }
+    if (!passed) {
+        std::cerr << "A warmed up render allocated." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,401 @@
+// audioAtlas.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Precomputed Hellschreiber audio for every glyph in a font, so
+//  that messages can be assembled by concatenating slices of the
+//  atlas rather than by synthesising audio on each run
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    audioAtlas.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+// The atlas file layout, all fields in host byte order:
+//
+//    AtlasHeader
+//    AtlasIndexEntry[glyphCount]   sorted by codepoint
+//    AtlasSlice[sliceCount]
+//    slice data
+//
+// Each slice holds a glyph's audio exactly as writeGlyphsToAudio()
+// would write it to the .raw file. Glyph audio is independent of
+// its neighbours, since generateAudio() restarts the tone phase at
+// the first row of every glyph, so slices can simply be butted
+// together. Codepoints with identical bitmaps share one slice, and
+// a slice is stored deflated whenever that makes it smaller, with
+// uncompressed slices being used straight out of the mapping.
+
+#include "audioAtlas.h"
+#include <algorithm>
+#include <thread>
+#include <cstdio>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char atlasMagic[8] = {'U','2','T','A','T','L','A','S'};
+static const uint32_t atlasVersion = 1;
+
+struct AtlasHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t floorFreq;
+    int32_t freqSpacing;
+    int32_t charLineDurationMS;
+    int32_t bitRate;
+    int32_t amplitude;
+    int32_t tor;
+    uint32_t glyphCount;
+    uint32_t sliceCount;
+    uint32_t reserved;
+    uint64_t indexOffset;
+    uint64_t sliceTableOffset;
+};
+
+struct AtlasIndexEntry {
+    uint32_t codepoint;
+    uint32_t slice;
+};
+
+struct AtlasSlice {
+    uint64_t offset;
+    uint32_t storedBytes; // == rawBytes if not deflated
+    uint32_t rawBytes;
+};
+
+static int atlasThreadCount() {
+    int threads = std::thread::hardware_concurrency();
+    return (threads > 0) ? threads : 1;
+}
+
+static void fillAtlasToneParameters(AtlasHeader & header,
+                                    const Glyph & glyph) {
+    header.floorFreq = glyph.floorFreq;
+    header.freqSpacing = glyph.freqSpacing;
+    header.charLineDurationMS = glyph.charLineDurationMS;
+    header.bitRate = glyph.bitRate;
+    header.amplitude = glyph.amplitude;
+    header.tor = glyph.tor;
+}
+
+// renders slices [first, last) across all cores, each thread taking
+// every nth slice, leaving the stored bytes in sliceData
+static void renderAtlasSlices(std::vector<Glyph*> & representatives,
+                              int first,
+                              int last,
+                              std::vector<std::vector<uint8_t> > & sliceData,
+                              std::vector<uint32_t> & rawBytes) {
+    int threadCount = atlasThreadCount();
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers.push_back(std::thread([&, thread]() {
+            vector<int8_t> audio;
+            vector<int> scratch;
+            for (int slice = first + thread; slice < last;
+                 slice += threadCount) {
+                Glyph & glyph = *representatives[slice];
+                audio.resize(glyph.audioLength());
+                scratch.resize(glyph.samplesPerRow());
+                glyph.renderVertAudio(audio.data(), scratch.data());
+                std::reverse(audio.begin(), audio.end()); // as written
+                std::vector<uint8_t> & stored = sliceData[slice - first];
+                uLongf deflatedBytes = compressBound(audio.size());
+                stored.resize(deflatedBytes);
+                if (compress2(&stored[0], &deflatedBytes,
+                              (const Bytef*)audio.data(), audio.size(),
+                              Z_BEST_SPEED) == Z_OK
+                    && deflatedBytes < audio.size()) {
+                    stored.resize(deflatedBytes);
+                } else {
+                    stored.assign(audio.begin(), audio.end());
+                }
+                rawBytes[slice] = audio.size();
+            }
+        }));
+    }
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers[thread].join();
+    }
+}
+
+int buildAudioAtlas(map<int, Glyph*> & glyphMap, string fName) {
+    std::vector<AtlasIndexEntry> index;
+    std::vector<Glyph*> glyphs;
+    map<int, Glyph*>::iterator iter;
+    for (iter = glyphMap.begin(); iter != glyphMap.end(); iter++) {
+        if (iter->second != 0) {
+            AtlasIndexEntry entry;
+            entry.codepoint = iter->first;
+            entry.slice = 0;
+            index.push_back(entry);
+            glyphs.push_back(iter->second);
+        }
+    }
+    if (glyphs.empty()) {
+        std::cout << "No glyphs to put in the atlas." << std::endl;
+        return 1;
+    }
+
+    // parsing is the bulk of the work in hashing, so spread it out
+    int threadCount = atlasThreadCount();
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers.push_back(std::thread([&, thread]() {
+            for (size_t glyph = thread; glyph < glyphs.size();
+                 glyph += threadCount) {
+                glyphs[glyph]->bitmapHash();
+            }
+        }));
+    }
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers[thread].join();
+    }
+
+    // codepoints with identical bitmaps share a slice
+    std::vector<Glyph*> representatives;
+    std::unordered_map<uint64_t, std::vector<uint32_t> > slicesByHash;
+    for (size_t glyph = 0; glyph < glyphs.size(); glyph++) {
+        std::vector<uint32_t> & candidates =
+            slicesByHash[glyphs[glyph]->bitmapHash()];
+        size_t candidate;
+        for (candidate = 0; candidate < candidates.size(); candidate++) {
+            if (representatives[candidates[candidate]]->bitmapRows()
+                == glyphs[glyph]->bitmapRows()) {
+                break;
+            }
+        }
+        if (candidate == candidates.size()) {
+            candidates.push_back(representatives.size());
+            representatives.push_back(glyphs[glyph]);
+        }
+        index[glyph].slice = candidates[candidate];
+    }
+
+    FILE * fOutput = fopen(fName.c_str(), "wb");
+    if (fOutput == 0) {
+        std::cout << "Unable to open atlas file: " << fName << std::endl;
+        return 1;
+    }
+    AtlasHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, atlasMagic, sizeof(atlasMagic));
+    header.version = atlasVersion;
+    fillAtlasToneParameters(header, *glyphs[0]);
+    header.glyphCount = index.size();
+    header.sliceCount = representatives.size();
+    header.indexOffset = sizeof(AtlasHeader);
+    header.sliceTableOffset =
+        header.indexOffset + index.size()*sizeof(AtlasIndexEntry);
+    uint64_t dataOffset = header.sliceTableOffset
+        + representatives.size()*sizeof(AtlasSlice);
+
+    // slice data is written a batch at a time, to keep memory use
+    // down, with the slice table filled in once all are written
+    std::vector<AtlasSlice> slices(representatives.size());
+    std::vector<uint32_t> rawBytes(representatives.size());
+    fseek(fOutput, dataOffset, SEEK_SET);
+    const int batchSize = 1024;
+    std::vector<std::vector<uint8_t> > sliceData(batchSize);
+    for (int first = 0; first < representatives.size();
+         first += batchSize) {
+        int last = std::min<int>(first + batchSize,
+                                 representatives.size());
+        renderAtlasSlices(representatives, first, last,
+                          sliceData, rawBytes);
+        for (int slice = first; slice < last; slice++) {
+            std::vector<uint8_t> & stored = sliceData[slice - first];
+            slices[slice].offset = dataOffset;
+            slices[slice].storedBytes = stored.size();
+            slices[slice].rawBytes = rawBytes[slice];
+            fwrite(stored.data(), 1, stored.size(), fOutput);
+            dataOffset += stored.size();
+            stored.clear();
+        }
+    }
+    fseek(fOutput, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fOutput);
+    fwrite(index.data(), sizeof(AtlasIndexEntry), index.size(), fOutput);
+    fwrite(slices.data(), sizeof(AtlasSlice), slices.size(), fOutput);
+    bool failed = ferror(fOutput);
+    failed = (fclose(fOutput) != 0) || failed;
+    if (failed) {
+        std::cout << "Error writing atlas file: " << fName << std::endl;
+        return 1;
+    }
+    std::cout << "Atlas of " << index.size() << " glyphs, "
+              << representatives.size() << " distinct bitmaps, "
+              << dataOffset << " bytes written to " << fName << std::endl;
+    return 0;
+}
+
+AudioAtlas::AudioAtlas() {
+    mapping = 0;
+    mappedBytes = 0;
+    header = 0;
+    index = 0;
+    slices = 0;
+}
+
+AudioAtlas::~AudioAtlas() {
+    close();
+}
+
+bool AudioAtlas::open(string fName) {
+    close();
+    int fd = ::open(fName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "Unable to open atlas file: " << fName << std::endl;
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0
+        || fileStat.st_size < sizeof(AtlasHeader)) {
+        ::close(fd);
+        std::cout << "Not an atlas file: " << fName << std::endl;
+        return false;
+    }
+    void * mapped = mmap(0, fileStat.st_size, PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cout << "Unable to map atlas file: " << fName << std::endl;
+        return false;
+    }
+    mapping = (const uint8_t*)mapped;
+    mappedBytes = fileStat.st_size;
+    header = (const AtlasHeader*)mapping;
+    if (memcmp(header->magic, atlasMagic, sizeof(atlasMagic))
+        || header->version != atlasVersion
+        || header->sliceTableOffset
+        + header->sliceCount*sizeof(AtlasSlice) > mappedBytes
+        || header->indexOffset
+        + header->glyphCount*sizeof(AtlasIndexEntry) > mappedBytes) {
+        std::cout << "Not a usable atlas file: " << fName << std::endl;
+        close();
+        return false;
+    }
+    index = (const AtlasIndexEntry*)(mapping + header->indexOffset);
+    slices = (const AtlasSlice*)(mapping + header->sliceTableOffset);
+    return true;
+}
+
+void AudioAtlas::close() {
+    if (mapping != 0) {
+        munmap((void*)mapping, mappedBytes);
+    }
+    mapping = 0;
+    mappedBytes = 0;
+    header = 0;
+    index = 0;
+    slices = 0;
+}
+
+bool AudioAtlas::matches(const Glyph & glyph) const {
+    AtlasHeader expected;
+    fillAtlasToneParameters(expected, glyph);
+    return header != 0
+        && header->floorFreq == expected.floorFreq
+        && header->freqSpacing == expected.freqSpacing
+        && header->charLineDurationMS == expected.charLineDurationMS
+        && header->bitRate == expected.bitRate
+        && header->amplitude == expected.amplitude
+        && header->tor == expected.tor;
+}
+
+bool AudioAtlas::audioFor(int codepoint,
+                          const int8_t * & audio,
+                          size_t & length,
+                          vector<int8_t> & scratch) const {
+    if (header == 0) {
+        return false;
+    }
+    const AtlasIndexEntry * last = index + header->glyphCount;
+    const AtlasIndexEntry * found =
+        std::lower_bound(index, last, (uint32_t)codepoint,
+                         [](const AtlasIndexEntry & entry,
+                            uint32_t wanted) {
+                             return entry.codepoint < wanted;
+                         });
+    if (found == last || found->codepoint != (uint32_t)codepoint
+        || found->slice >= header->sliceCount) {
+        return false;
+    }
+    const AtlasSlice & slice = slices[found->slice];
+    if (slice.offset + slice.storedBytes > mappedBytes) {
+        return false;
+    }
+    if (slice.storedBytes == slice.rawBytes) {
+        audio = (const int8_t*)(mapping + slice.offset);
+        length = slice.rawBytes;
+        return true;
+    }
+    scratch.resize(slice.rawBytes);
+    uLongf inflatedBytes = slice.rawBytes;
+    if (uncompress((Bytef*)scratch.data(), &inflatedBytes,
+                   mapping + slice.offset,
+                   slice.storedBytes) != Z_OK
+        || inflatedBytes != slice.rawBytes) {
+        return false;
+    }
+    audio = scratch.data();
+    length = inflatedBytes;
+    return true;
+}
+
+size_t AudioAtlas::glyphCount() const {
+    return (header != 0) ? header->glyphCount : 0;
+}
+
+// slices are written straight out of the mapping where they can be
+int writeAtlasGlyphsToAudio(const AudioAtlas & atlas,
+                            std::string_view glyphString,
+                            int extraSpaces,
+                            string fName) {
+    FILE * fOutput = fopen(fName.c_str(), "wb");
+    if (fOutput == 0) {
+        std::cout << "Unable to open output file: " << fName << std::endl;
+        return 1;
+    }
+    Utf8Tokenizer tokens(glyphString, extraSpaces);
+    vector<int8_t> scratch;
+    int codepoint;
+    while (tokens.next(codepoint)) {
+        const int8_t * audio;
+        size_t length;
+        bool found;
+        {
+            StageTimer timer(renderStats.synthesisSeconds);
+            found = atlas.audioFor(codepoint, audio, length, scratch);
+        }
+        if (found) {
+            StageTimer timer(renderStats.writeSeconds);
+            fwrite(audio, 1, length, fOutput);
+            renderStats.glyphsRendered++;
+            renderStats.samplesProduced += length;
+            renderStats.bytesWritten += length;
+        } else {
+            std::cerr << "Glyph "<< codepoint
+                      << " not found in atlas." << std::endl;
+            renderStats.missingGlyphs++;
+        }
+    }
+    bool failed = ferror(fOutput);
+    failed = (fclose(fOutput) != 0) || failed;
+    return failed ? 1 : 0;
+}
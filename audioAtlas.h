@@ -0,0 +1,81 @@
+// audioAtlas.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Precomputed Hellschreiber audio for every glyph in a font, so
+//  that messages can be assembled by concatenating slices of the
+//  atlas rather than by synthesising audio on each run
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    audioAtlas.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef AUDIOATLAS_H
+#define AUDIOATLAS_H
+
+#include "bitmap2waterfall.h"
+
+// laid out in audioAtlas.cc
+struct AtlasHeader;
+struct AtlasIndexEntry;
+struct AtlasSlice;
+
+int buildAudioAtlas(map<int, Glyph*> & glyphMap, string fName);
+
+// a read only view of an atlas file, which is mapped rather than read
+class AudioAtlas {
+public:
+
+    AudioAtlas();
+
+    ~AudioAtlas();
+
+    bool open(string fName);
+
+    void close();
+
+    // true if the atlas was built with the same tone parameters
+    // as the given glyph would use
+    bool matches(const Glyph & glyph) const;
+
+    // points audio at the codepoint's slice, inflating into scratch
+    // if the slice was stored deflated; false if not in the atlas
+    bool audioFor(int codepoint,
+                  const int8_t * & audio,
+                  size_t & length,
+                  vector<int8_t> & scratch) const;
+
+    size_t glyphCount() const;
+
+private:
+
+    const uint8_t * mapping;
+    size_t mappedBytes;
+    const AtlasHeader * header;
+    const AtlasIndexEntry * index;
+    const AtlasSlice * slices;
+};
+
+
+// the atlas equivalent of writeGlyphsToAudio(), without any synthesis
+int writeAtlasGlyphsToAudio(const AudioAtlas & atlas,
+                            std::string_view glyphString,
+                            int extraSpaces,
+                            string fName);
+
+#endif
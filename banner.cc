@@ -0,0 +1,163 @@
+// banner.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Renders a whole string as an ASCII, or Unicode block, banner,
+//  with glyphs laid side by side and wrapped to a given width, in
+//  any of the four orientations used by Glyph::printSym()
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    banner.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "banner.h"
+#include <cstdio>
+
+// laid out upright into a page of pixels first, a glyph wider than
+// width getting a line to itself, then the page is emitted rotated
+void renderBanner(map<int, Glyph*> & glyphMap,
+                  std::string_view text,
+                  char dir,
+                  int width,
+                  BannerStyle style,
+                  string & banner) {
+    struct Tile {
+        const PackedBitmap * bitmap;
+        int x;
+        int y;
+    };
+    std::vector<Tile> tiles;
+    std::vector<int> lineHeights;
+    int pageWidth = 0;
+    int pageHeight = 0;
+    int x = 0;
+    int lineHeight = 0;
+
+    Utf8Tokenizer tokens(text);
+    int codepoint;
+    while (tokens.next(codepoint)) {
+        if (codepoint == '\n') {
+            pageHeight += lineHeight;
+            x = 0;
+            lineHeight = 0;
+            continue;
+        }
+        map<int, Glyph*>::iterator found = glyphMap.find(codepoint);
+        if (found == glyphMap.end() || found->second == 0) {
+            renderStats.missingGlyphs++;
+            continue;
+        }
+        const PackedBitmap & bitmap = found->second->packedBitmap();
+        if (x > 0 && x + bitmap.width > width) { // wrap
+            pageHeight += lineHeight;
+            x = 0;
+            lineHeight = 0;
+        }
+        Tile tile;
+        tile.bitmap = &bitmap;
+        tile.x = x;
+        tile.y = pageHeight;
+        tiles.push_back(tile);
+        renderStats.glyphsRendered++;
+        x += bitmap.width;
+        if (x > pageWidth) {
+            pageWidth = x;
+        }
+        if (bitmap.height > lineHeight) {
+            lineHeight = bitmap.height;
+        }
+    }
+    pageHeight += lineHeight;
+
+    std::vector<uint8_t> page(pageWidth*pageHeight, 0);
+    for (int tile = 0; tile < tiles.size(); tile++) {
+        const PackedBitmap & bitmap = *tiles[tile].bitmap;
+        for (int row = 0; row < bitmap.height; row++) {
+            uint8_t * pixel = &page[(tiles[tile].y + row)*pageWidth
+                                    + tiles[tile].x];
+            uint64_t bits = bitmap.rows[row];
+            for (int col = 0; col < bitmap.width; col++) {
+                pixel[col] = (bits >> col) & 1;
+            }
+        }
+    }
+
+    // the page seen in the requested orientation, as outWidth by
+    // outHeight pixels, with pixelAt() mapping back onto the page
+    int outWidth = pageWidth;
+    int outHeight = pageHeight;
+    if (dir == 'L' || dir == 'R') {
+        outWidth = pageHeight;
+        outHeight = pageWidth;
+    }
+    auto pixelAt = [&](int col, int row) -> bool {
+        if (row >= outHeight) {
+            return false;
+        }
+        switch (dir) {
+        case 'D':
+            return page[(pageHeight - 1 - row)*pageWidth
+                        + (pageWidth - 1 - col)];
+        case 'L':
+            return page[col*pageWidth + (pageWidth - 1 - row)];
+        case 'R':
+            return page[(pageHeight - 1 - col)*pageWidth + row];
+        default:
+            return page[row*pageWidth + col];
+        }
+    };
+
+    banner.clear();
+    if (style == bannerBlocks) {
+        static const char * halves[4] = {" ", "▀", "▄", "█"};
+        banner.reserve(((outHeight + 1)/2)*(outWidth*3 + 1));
+        for (int row = 0; row < outHeight; row += 2) {
+            for (int col = 0; col < outWidth; col++) {
+                banner += halves[pixelAt(col, row)
+                                 | (pixelAt(col, row + 1) << 1)];
+            }
+            banner += '\n';
+        }
+    } else {
+        banner.reserve(outHeight*(outWidth + 1));
+        for (int row = 0; row < outHeight; row++) {
+            for (int col = 0; col < outWidth; col++) {
+                banner += pixelAt(col, row) ? '#' : '-';
+            }
+            banner += '\n';
+        }
+    }
+}
+
+// the banner goes out in a single write
+int writeBanner(const string & banner, string fName) {
+    FILE * fOutput = (fName.length() == 0) ? stdout
+        : fopen(fName.c_str(), "wb");
+    if (fOutput == 0) {
+        std::cout << "Unable to open output file: " << fName << std::endl;
+        return 1;
+    }
+    bool failed = fwrite(banner.data(), 1, banner.size(), fOutput)
+        != banner.size();
+    if (fOutput == stdout) {
+        failed = (fflush(fOutput) != 0) || failed;
+    } else {
+        failed = (fclose(fOutput) != 0) || failed;
+    }
+    return failed ? 1 : 0;
+}
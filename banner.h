@@ -0,0 +1,51 @@
+// banner.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Renders a whole string as an ASCII, or Unicode block, banner,
+//  with glyphs laid side by side and wrapped to a given width, in
+//  any of the four orientations used by Glyph::printSym()
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    banner.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef BANNER_H
+#define BANNER_H
+
+#include "bitmap2waterfall.h"
+
+enum BannerStyle {
+    bannerAscii,  // "#" and "-", as printSym() does
+    bannerBlocks  // Unicode half blocks, two pixel rows per line
+};
+
+// the text as a banner, upright (U), upside down (D) or rotated left
+// (L) or right (R), in lines of at most width pixels; for L and R
+// the lines run down the output, so width limits its height
+void renderBanner(map<int, Glyph*> & glyphMap,
+                  std::string_view text,
+                  char dir,
+                  int width,
+                  BannerStyle style,
+                  string & banner);
+
+// to fName, or to stdout if fName is empty
+int writeBanner(const string & banner, string fName);
+
+#endif
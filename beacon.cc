@@ -0,0 +1,183 @@
+// beacon.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Beacon mode, a message rendered once and then sent over and over
+//  from the same buffer
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    beacon.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+// Glyph audio is independent of its neighbours, generateAudio()
+// restarting the tone phase and tapering each row's tone in and out,
+// so the join from the end of the message back to its start is no
+// different to the join between any two glyphs: nothing needs
+// matching in the usual case. The ends are still checked, in case
+// the tone parameters ever leave a tone running at a glyph's edge,
+// and given a short raised cosine fade if so.
+//
+// Streaming writes the one buffer over and over with writev(), each
+// call being handed up to IOV_MAX iovecs all pointing at it; if
+// stdout is a pipe, vmsplice() is used instead, which lends the
+// buffer's pages to the pipe rather than copying them. Lent pages
+// must not change while the pipe may still hold them, which can be
+// long after streamBeacon() returns, so they are never the caller's
+// vector but a read only copy in a mapping of their own, which stays
+// mapped, and untouched, until the process exits.
+
+#include "beacon.h"
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+static const int loopFadeSamples = 40; // 5 ms at 8000 Hz
+static const int loopQuietLevel = 2;   // the taper's first step
+
+static void fadeLoopPoint(std::vector<int8_t> & audio) {
+    int fade = std::min((size_t)loopFadeSamples, audio.size()/2);
+    int loudest = 0;
+    for (int sample = 0; sample < 4 && sample < fade; sample++) {
+        loudest = std::max(loudest, std::abs((int)audio[sample]));
+        loudest = std::max(loudest,
+                           std::abs((int)audio[audio.size() - 1 - sample]));
+    }
+    if (loudest <= loopQuietLevel) {
+        return;
+    }
+    for (int sample = 0; sample < fade; sample++) {
+        double gain = 0.5 - 0.5*cos(M_PI*sample/fade);
+        audio[sample] = (int8_t)lround(audio[sample]*gain);
+        audio[audio.size() - 1 - sample] =
+            (int8_t)lround(audio[audio.size() - 1 - sample]*gain);
+    }
+    std::cerr << "Loop point faded over " << fade << " samples."
+              << std::endl;
+}
+
+int renderBeacon(map<int, Glyph*> & glyphMap,
+                 std::string_view glyphString,
+                 int extraSpaces,
+                 GlyphAudioCache * cache,
+                 std::vector<int8_t> & audio) {
+    RenderContext context;
+    audio.clear();
+    Utf8Tokenizer tokens(glyphString, extraSpaces);
+    int codepoint;
+    while (tokens.next(codepoint)) {
+        size_t length;
+        const int8_t * glyphAudio = renderGlyphCodeAudio(glyphMap, codepoint,
+                                                         cache, context,
+                                                         length);
+        if (glyphAudio == 0) {
+            std::cerr << "Glyph " << codepoint
+                      << " not found in bdf file." << std::endl;
+            continue;
+        }
+        audio.insert(audio.end(), glyphAudio, glyphAudio + length);
+    }
+    if (audio.empty()) {
+        std::cerr << "Nothing to send as a beacon." << std::endl;
+        return 1;
+    }
+    fadeLoopPoint(audio);
+    return 0;
+}
+
+// the copy of audio which vmsplice() lends to the pipe; deliberately
+// never written again nor unmapped, 0 if it can't be mapped
+static const int8_t * splicableCopy(const std::vector<int8_t> & audio) {
+    void * mapping = mmap(0, audio.size(), PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return 0;
+    }
+    memcpy(mapping, audio.data(), audio.size());
+    mprotect(mapping, audio.size(), PROT_READ);
+    return (const int8_t *)mapping;
+}
+
+int streamBeacon(const std::vector<int8_t> & audio,
+                 long repeats,
+                 string fName) {
+    bool toStdout = (fName == "-");
+    int fd = toStdout ? STDOUT_FILENO
+        : open(fName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Unable to open output file: " << fName << std::endl;
+        return 1;
+    }
+    struct stat fileStat;
+    bool pipe = fstat(fd, &fileStat) == 0 && S_ISFIFO(fileStat.st_mode);
+    const int8_t * source = audio.data();
+    if (pipe) {
+        source = splicableCopy(audio);
+        pipe = (source != 0);
+        if (!pipe) {
+            source = audio.data();
+        }
+    }
+
+    size_t length = audio.size();
+    std::vector<struct iovec> copies(IOV_MAX);
+    for (size_t copy = 0; copy < copies.size(); copy++) {
+        copies[copy].iov_base = (void*)source;
+        copies[copy].iov_len = length;
+    }
+    long remaining = repeats; // copies not yet fully written
+    size_t offset = 0;        // into the copy being written
+    bool failed = false;
+    StageTimer timer(renderStats.writeSeconds);
+    while (repeats == 0 || remaining > 0) {
+        int count = (repeats == 0 || remaining > IOV_MAX)
+            ? IOV_MAX : remaining;
+        copies[0].iov_base = (void*)(source + offset);
+        copies[0].iov_len = length - offset;
+        ssize_t written = pipe ? vmsplice(fd, copies.data(), count, 0)
+            : writev(fd, copies.data(), count);
+        copies[0].iov_base = (void*)source;
+        copies[0].iov_len = length;
+        if (written < 0 && errno == EINVAL && pipe) {
+            pipe = false; // not every pipe takes vmsplice()
+            continue;
+        }
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed = (errno != EPIPE);
+            break;
+        }
+        renderStats.bytesWritten += written;
+        offset += written;
+        remaining -= offset/length;
+        offset %= length;
+    }
+    if (!toStdout) {
+        failed = (close(fd) != 0) || failed;
+    }
+    if (failed) {
+        std::cerr << "Unable to write beacon to " << fName << std::endl;
+        return 1;
+    }
+    return 0;
+}
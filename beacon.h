@@ -0,0 +1,48 @@
+// beacon.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Beacon mode, a message rendered once and then sent over and over
+//  from the same buffer
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    beacon.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef BEACON_H
+#define BEACON_H
+
+#include "bitmap2waterfall.h"
+
+// the message's audio, in file order, with the loop point checked so
+// that back to back copies play without a click; progress and
+// missing glyphs are reported on stderr, as stdout may carry audio
+int renderBeacon(map<int, Glyph*> & glyphMap,
+                 std::string_view glyphString,
+                 int extraSpaces,
+                 GlyphAudioCache * cache,
+                 std::vector<int8_t> & audio);
+
+// writes audio repeats times, or forever if repeats is 0, to fName,
+// or to stdout if fName is "-"; a reader closing the pipe ends the
+// beacon, as long as the caller has SIGPIPE ignored, as main does
+int streamBeacon(const std::vector<int8_t> & audio,
+                 long repeats,
+                 string fName);
+
+#endif
@@ -0,0 +1,304 @@
+// bench.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Micro and macro benchmarks for gnuUnifont2things, covering font
+//  loading, tokenizing, audio synthesis and writing audio out.
+//
+//  Usage: make bench [BENCHFONT=font.bdf]
+//     or: ./benchmarks [font.bdf]
+//
+//  Each result is printed as one JSON object per line, i.e.
+//
+//  {"bench":"...","iterations":n,"ns_per_op":x,"samples_per_s":y,
+//   "allocs_per_op":a,"peak_rss_kb":z}
+//
+//  where samples_per_s is 0 for stages which do not produce audio,
+//  and allocs_per_op counts calls to operator new.
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    bench.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "bitmap2waterfall.h"
+#include "allocCounter.h"
+#include <chrono>
+#include <functional>
+#include <cstdio>
+
+using namespace std;
+
+static const double minBenchSeconds = 0.5;
+
+// runs op until minBenchSeconds have passed, at least once, and
+// reports the mean time per call; samplesPerOp is the audio
+// produced by each call, if any
+static void runBench(string name,
+                     std::function<void()> op,
+                     double samplesPerOp = 0,
+                     int maxIterations = 1000000) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    double elapsed = 0;
+    long iterations = 0;
+    unsigned long allocationsBefore = heapAllocations;
+    do {
+        op();
+        iterations++;
+        elapsed = std::chrono::duration<double>
+            (std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < minBenchSeconds && iterations < maxIterations);
+    double nsPerOp = elapsed*1e9/iterations;
+    double samplesPerSecond = (samplesPerOp*iterations)/elapsed;
+    double allocationsPerOp =
+        (double)(heapAllocations - allocationsBefore)/iterations;
+    printf("{\"bench\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.1f,"
+           "\"samples_per_s\":%.1f,\"allocs_per_op\":%.2f,"
+           "\"peak_rss_kb\":%ld}\n",
+           name.c_str(), iterations, nsPerOp, samplesPerSecond,
+           allocationsPerOp, peakRssKB());
+    fflush(stdout);
+}
+
+static string repeatText(string text, size_t totalBytes) {
+    string repeated;
+    repeated.reserve(totalBytes + text.length());
+    while (repeated.length() < totalBytes) {
+        repeated += text;
+    }
+    return repeated;
+}
+
+// a glyph built straight from a BDF style definition, so the
+// synthesis benchmarks do not depend on the font being present
+static Glyph * syntheticGlyph(int width, std::vector<string> bitmap) {
+    std::list<std::string> definition;
+    std::ostringstream bbx;
+    bbx << "BBX " << width << " " << bitmap.size() << " 0 -2";
+    std::ostringstream dwidth;
+    dwidth << "DWIDTH " << width << " 0";
+    definition.push_back("STARTCHAR synthetic");
+    definition.push_back("ENCODING 0");
+    definition.push_back(dwidth.str());
+    definition.push_back(bbx.str());
+    definition.push_back("BITMAP");
+    for (size_t row = 0; row < bitmap.size(); row++) {
+        definition.push_back(bitmap[row]);
+    }
+    definition.push_back("ENDCHAR");
+    return new Glyph(definition);
+}
+
+static void benchRowPatterns() {
+    Glyph * glyph = syntheticGlyph(8, std::vector<string>(16, "00"));
+    double samples = (glyph->bitRate*glyph->charLineDurationMS)/1000;
+    string blank = "----------------";
+    string solid = "################";
+    string alternate = "#-#-#-#-#-#-#-#-";
+    runBench("generateAudio/blank", [&]() {
+            glyph->generateAudio(blank, blank, blank, 5);
+        }, samples);
+    runBench("generateAudio/solid_steady", [&]() {
+            glyph->generateAudio(solid, solid, solid, 5);
+        }, samples);
+    runBench("generateAudio/solid_rising", [&]() {
+            glyph->generateAudio(blank, solid, solid, 5);
+        }, samples);
+    runBench("generateAudio/solid_falling", [&]() {
+            glyph->generateAudio(solid, solid, blank, 5);
+        }, samples);
+    runBench("generateAudio/solid_isolated", [&]() {
+            glyph->generateAudio(blank, solid, blank, 5);
+        }, samples);
+    runBench("generateAudio/alternate_steady", [&]() {
+            glyph->generateAudio(alternate, alternate, alternate, 5);
+        }, samples);
+    delete glyph;
+}
+
+// a message rendered row by row straight into a reused arena; once
+// warmed up this should report zero allocations per message
+static void benchArenaRender(string name, std::vector<Glyph*> glyphs) {
+    RenderContext context;
+    double samples = 0;
+    for (size_t glyph = 0; glyph < glyphs.size(); glyph++) {
+        samples += glyphs[glyph]->audioLength();
+    }
+    std::function<void()> render = [&]() {
+        for (size_t glyph = 0; glyph < glyphs.size(); glyph++) {
+            context.arena.reset();
+            int8_t * out =
+                context.arena.allocate<int8_t>(glyphs[glyph]->audioLength());
+            int * scratch =
+                context.arena.allocate<int>(glyphs[glyph]->samplesPerRow());
+            glyphs[glyph]->renderVertAudio(out, scratch);
+        }
+    };
+    render(); // warm up the arena
+    runBench("renderVertAudio/" + name, render, samples);
+}
+
+static void benchGlyphClass(string name, Glyph * glyph) {
+    if (glyph == 0) {
+        return;
+    }
+    double samples = glyph->audioSym('U').size();
+    runBench("vertSymAudio/" + name, [&]() {
+            glyph->audioSym('U');
+        }, samples);
+}
+
+static void benchGlyphClasses(map<int, Glyph*> & glyphMap) {
+    std::vector<string> latin;
+    latin.push_back("00");
+    latin.push_back("00");
+    latin.push_back("00");
+    latin.push_back("00");
+    latin.push_back("18");
+    latin.push_back("24");
+    latin.push_back("24");
+    latin.push_back("42");
+    latin.push_back("42");
+    latin.push_back("7E");
+    latin.push_back("42");
+    latin.push_back("42");
+    latin.push_back("42");
+    latin.push_back("42");
+    latin.push_back("00");
+    latin.push_back("00");
+    std::vector<string> cjk;
+    for (int row = 0; row < 16; row++) {
+        cjk.push_back((row % 3) ? "4924" : "7FFE");
+    }
+    Glyph * syntheticLatin = syntheticGlyph(8, latin);
+    Glyph * syntheticCJK = syntheticGlyph(16, cjk);
+    Glyph * syntheticBlank =
+        syntheticGlyph(8, std::vector<string>(16, "00"));
+    benchGlyphClass("latin_synthetic", syntheticLatin);
+    benchGlyphClass("cjk_synthetic", syntheticCJK);
+    benchGlyphClass("blank_synthetic", syntheticBlank);
+    std::vector<Glyph*> message;
+    message.push_back(syntheticLatin);
+    message.push_back(syntheticBlank);
+    message.push_back(syntheticCJK);
+    message.push_back(syntheticLatin);
+    benchArenaRender("arena_message_synthetic", message);
+    delete syntheticLatin;
+    delete syntheticCJK;
+    delete syntheticBlank;
+
+    int fontCodes[] = {'A', 0x4E00, ' '};
+    string fontNames[] = {"latin_font", "cjk_font", "blank_font"};
+    for (int index = 0; index < 3; index++) {
+        map<int, Glyph*>::iterator found = glyphMap.find(fontCodes[index]);
+        if (found != glyphMap.end()) {
+            benchGlyphClass(fontNames[index], found->second);
+        }
+    }
+}
+
+static void benchTokenizer() {
+    string ascii = repeatText("The quick brown fox jumps over the lazy dog. ",
+                              1 << 20);
+    string cjk = repeatText("漢字仮名交じり文한국어", 1 << 20);
+    string escapes = repeatText("U+262FU+2603U+41", 1 << 20);
+    runBench("stringToGlyphCodeVector/ascii_1MiB", [&]() {
+            stringToGlyphCodeVector(ascii, 0);
+        });
+    runBench("stringToGlyphCodeVector/cjk_1MiB", [&]() {
+            stringToGlyphCodeVector(cjk, 0);
+        });
+    runBench("stringToGlyphCodeVector/escapes_1MiB", [&]() {
+            stringToGlyphCodeVector(escapes, 0);
+        });
+    runBench("stringToGlyphCodeVector/ascii_1MiB_spaced", [&]() {
+            stringToGlyphCodeVector(ascii, 1);
+        });
+}
+
+static double messageSamples(map<int, Glyph*> & glyphMap, string text) {
+    double samples = 0;
+    vector<int> codes = stringToGlyphCodeVector(text, 0);
+    for (size_t index = 0; index < codes.size(); index++) {
+        map<int, Glyph*>::iterator found = glyphMap.find(codes[index]);
+        if (found != glyphMap.end()) {
+            samples += found->second->bitmapRows().size()
+                * ((found->second->bitRate
+                    * found->second->charLineDurationMS)/1000);
+        }
+    }
+    return samples;
+}
+
+static void benchEndToEnd(map<int, Glyph*> & glyphMap) {
+    string message = "CQ CQ CQ de VK5 the quick brown fox jumps over "
+        "the lazy dog 0123456789 漢字 U+262F";
+    string fName = "bench_output.raw";
+    double samples = messageSamples(glyphMap, message);
+    runBench("writeGlyphsToAudio/message", [&]() {
+            std::streambuf * saved = std::cout.rdbuf(0); // quieten
+            writeGlyphsToAudio(glyphMap, message, 0, fName, 0);
+            std::cout.rdbuf(saved);
+        }, samples, 20);
+    runBench("writeGlyphsToAudio/message_cached", [&]() {
+            GlyphAudioCache cache;
+            std::streambuf * saved = std::cout.rdbuf(0);
+            writeGlyphsToAudio(glyphMap, message, 0, fName, 0, &cache);
+            std::cout.rdbuf(saved);
+        }, samples, 20);
+    std::vector<Glyph*> glyphs;
+    vector<int> codes = stringToGlyphCodeVector(message, 0);
+    for (size_t index = 0; index < codes.size(); index++) {
+        map<int, Glyph*>::iterator found = glyphMap.find(codes[index]);
+        if (found != glyphMap.end()) {
+            glyphs.push_back(found->second);
+        }
+    }
+    benchArenaRender("arena_message", glyphs);
+    remove(fName.c_str());
+}
+
+int main (int argc, char * argv[]) {
+    string fontFile = "unifont-8.0.01.bdf";
+    if (argc > 1) {
+        fontFile = argv[1];
+    }
+
+    std::map<int, Glyph*> glyphMap;
+    std::ifstream fontCheck(fontFile.c_str());
+    bool haveFont = fontCheck.good();
+    fontCheck.close();
+    if (haveFont) {
+        runBench("load_bdf_file", [&]() {
+                cleanUpGlyphMap(glyphMap);
+                glyphMap = load_bdf_file(fontFile);
+            }, 0, 5);
+    } else {
+        std::cerr << "Font " << fontFile << " not found, "
+                  << "skipping font based benchmarks." << std::endl;
+    }
+
+    benchTokenizer();
+    benchRowPatterns();
+    benchGlyphClasses(glyphMap);
+    if (haveFont) {
+        benchEndToEnd(glyphMap);
+    }
+    cleanUpGlyphMap(glyphMap);
+    return 0;
+}
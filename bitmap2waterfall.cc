@@ -30,804 +30,296 @@
 //    bitmap2waterfall.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
 //
 
-#include <iostream>
-#include <fstream>
-#include <cstring>
-#include <cstdlib>
-#include <string>
-#include <sstream>
-#include <map>
-#include <list>
-#include <vector>
-#include <cmath>
 
-#define VERBOSE 0
+#include "bitmap2waterfall.h"
 
-using namespace std;
-
-class Glyph {
-public:
-
-    Glyph(std::list<std::string> data,
-          int ascent = 14, 
-          int descent = 2) {
-        fontAscent = ascent;
-        fontDescent = descent;
-        glyphDef = data;
-        parsed = 0;
-        floorFreq = 800;
-        freqSpacing = 17;
-        charLineDurationMS = 200; // was 10
-        bitRate = 8000;
-        nbits = 16; // not used currently 
-        amplitude = 127; //pow(2, nbits-1) - 1;
-        tor = 16;//4; // time constant for gaussian error function, ms 
-        // but for now being used to ramp tone on/off
-        pulseDuration = 0; // for gaussian error function in due course
-    }
-
-    ~Glyph() {
-        cleanUp();
-    }
-
-    void printSymSummary() {
-        glyphInit();
-        std::cout << "Summary: " << std::endl << " BBXx: "
-                  << BBXx << ", BBXy: " << BBXy << std::endl
-                  << "BBXxOffset: " << BBXxOffset
-                  << ", BBXyOffset: " << BBXyOffset << std::endl
-                  << "dispWidth:" << dispWidth << std::endl;
-    }
- 
-    void printSym(char dir) {
-        switch (dir) {
-        case 'U':
-            vertSymAscii();
-            break;
-        case 'D':
-            piRotatedSymAscii();
-            break;
-        case 'L':
-            leftRotSymAscii();
-            break;
-        case 'R':
-            rightRotSymAscii();
-            break;            
-        }
-    }
-
-    vector<int8_t> audioSym(char dir) {
-        switch (dir) {
-        case 'U':
-            return vertSymAudio();
-        case 'D':
-            return piRotatedSymAudio();
-        case 'L':
-            return leftRotSymAudio();
-        case 'R':
-            return rightRotSymAudio();
-        }
-    }
-
-    friend ostream& operator<<(ostream& output, const Glyph& g) {
-        std::list<string>::const_iterator iter;
-        //output << "Glyph definition: " << g.glyphDef.front() ;
-        for (iter = g.glyphDef.begin();
-             iter != g.glyphDef.end(); ++iter) {
-            output << *iter << std::endl;
-        }
-        return output;
-    }
-
-    std::list<std::string> glyphDef;
-    std::vector<std::string> asciiBitmap;
-    std::vector<string> outputRows;
-    std::vector<int8_t> symbolAudio;
-    std::vector<int8_t> tempAudio;
-
-    int fontAscent;
-    int fontDescent;
-
-    int BBXx;
-    int BBXy;
-    int BBXxOffset;
-    int BBXyOffset;
-
-    int dispWidth;
-    int paddingLineWidth;
-
-    int floorFreq;
-    int freqSpacing;
-    int charLineDurationMS;
-    int bitRate;
-    int nbits;
-    int amplitude;
-
-    bool parsed;
-
-    string whitespace;
-    string currentLine; 
-    string currentRow;
-    string output;
-
-    int tor; // time constant for gaussian error function, ms 
-    int pulseDuration;
-
-    static const double envelope[];
-    
-private:
-    
-   void cleanUp() {
-        glyphDef.clear();
-        asciiBitmap.clear();
-        outputRows.clear();
-    }
-
-    static string padding(int num, string pad) {
-        if (num < 1 ) { // i.e. if BBXxOffset < 1, we do nothing
-            return "";
-        } else {
-            return pad + padding(num-1, pad);
-        }
-    }
-
-    string paddingLine(int num, string pad) {
-        whitespace = "";
-        if (BBXx < dispWidth) {
-            num = dispWidth;
-        }
-        if (BBXxOffset > 0) {
-            num += BBXxOffset;
-        }
-        for (int count = 0; count < num; count++) {
-            whitespace = whitespace + pad;
-        }
-        return whitespace;
-    }
-
-    void glyphInit() {
-        if (parsed == 0) {
-            parseDef();
-            parsed = 1;
-        }
-    }
-
-    void parseDef() {
-        list<std::string>::iterator it1, it2;
-        it1 = glyphDef.begin();
-        it2 = glyphDef.end(); //ignore "ENDCHAR"
-        int index1 = 0;
-        int index2 = 0;
-        for (; it1 != it2; it1++) {
-            currentLine = *it1;
-            if (!strcmp(currentLine.substr(0,4).c_str(), "BBX ")) {
-                index1 = index2 = 4;
-                while (currentLine[index2] != ' ') {
-                    index2++;
-                }
-                BBXx = 
-                    std::atoi(currentLine.substr(index1, index2-1).c_str());
-                index1 = index2;
-                index2++;
-                while (currentLine[index2] != ' ') {
-                    index2++;
-                }
-                BBXy = 
-                    std::atoi(currentLine.substr(index1, index2-1).c_str());
-                index1 = index2;
-                index2++;
-                while (currentLine[index2] != ' ') {
-                    index2++;
-                }
-                BBXxOffset = 
-                    std::atoi(currentLine.substr(index1, index2-1).c_str());
-                index1 = index2;
-                BBXyOffset = 
-                    std::atoi(currentLine.substr(index1).c_str());
-            } else if (!strcmp(currentLine.substr(0,7).c_str(), "DWIDTH ")) {
-                index1 = index2 = 7;
-                while (currentLine[index2] != ' ') {
-                    index2++;
-                }
-                dispWidth = 
-                    std::atoi(currentLine.substr(index1, index2-1).c_str());
-            } else if (!strcmp(currentLine.substr(0,6).c_str(), "BITMAP")) {
-                // we move onto the next line, into the bitmapping
-                for (it1++; it1 != it2; it1++) {
-                    currentLine = *it1;
-                    if (strcmp(currentLine.substr(0,7).c_str(), "ENDCHAR")) {
-                        asciiBitmap.push_back(currentLine);
-                    }
-                }
-                // now sort out the outer for loop
-                if (it1 == it2) {
-                    it1--;
-                }
-            }
-        }
-        parsed = 1;
-        processBitmap();
-    }
-
-    void processBitmap() {
-
-        paddingLineWidth = asciiBitmap[0].length()*4;
-
-        if (BBXxOffset < 0) {
-            paddingLineWidth -= BBXxOffset;
-        } else {
-            paddingLineWidth += BBXxOffset;
-        }
-
-        // this is helpful for firefly bdf but not crucial
-        // for unifont.bdf which has uniform glyph heights
-        if (BBXyOffset < 0 ) {
-            for (int count = 0; count > BBXyOffset; count--) {
-                output = paddingLine(paddingLineWidth, "-");
-                outputRows.push_back(output);
-            }
-        }
-
-        // could do (fontAscent - glyphHeight) padding
-        // rows here I think but unifont.bdf
-        // is well behaved WRT BBX height=16 for all glyphs 
-        for (int index = 0; index < BBXy; index++) {
-            currentRow = asciiBitmap[index];
-            output = ""; // zero it out
-            for (int column = 0;
-                 column < currentRow.length(); column++) {
-                switch (currentRow[column]) {
-                case '0':
-                    output = output + "----";
-                    break;
-                case '1':
-                    output = output + "---#";
-                    break;
-                case '2':
-                    output = output + "--#-";
-                    break;
-                case '3':
-                    output = output + "--##";
-                    break;
-                case '4':
-                    output = output + "-#--";
-                    break;
-                case '5':
-                    output = output + "-#-#";
-                    break;
-                case '6':
-                    output = output + "-##-";
-                    break;
-                case '7':
-                    output = output + "-###";
-                    break;
-                case '8':
-                    output = output + "#---";
-                    break;
-                case '9':
-                    output = output + "#--#";
-                    break;
-                case 'A':
-                    output = output + "#-#-";
-                    break;
-                case 'B':
-                    output = output + "#-##";
-                    break;
-                case 'C':
-                    output = output + "##--";
-                    break;
-                case 'D':
-                    output = output + "##-#";
-                    break;
-                case 'E':
-                    output = output + "###-";
-                    break;
-                case 'F':
-                    output = output + "####";
-                    break;
-                }
+// a glyph is taken to end at ENDCHAR, or at the next STARTCHAR or
+// ENDFONT, or at the end of a truncated file
+template<class LineReader>
+static map<int, Glyph*> parseBDFLines(LineReader & input) {
+    std::string latestLine = "";
+    std::list<std::string> symbolDef;
+    int currentID = 0;
+    std::map<int, Glyph*> glyphMap;
+    while (input.getline(latestLine)) {
+        if (!strcmp(latestLine.substr(0,9).c_str(), "STARTCHAR")) {
+            symbolDef.clear();
+            symbolDef.push_back(latestLine); // store "STARTCHAR line"
+            if (!input.getline(latestLine)) {
+                break;
             }
-            output = padding(BBXxOffset, "-") + output;
-            outputRows.push_back(output);
-            output = "";
-        }
-        if (BBXy < 16){// we do this to sort out descending and
-            // ascending limbs, such as on l, k, q, p etc...
-            // not actually used with unifont.bdf
-            for (int count = 0; // (+2 - BBXyOffset) is about right
-                 // this is the "FONT_DESCENT" in the bdf
-                 count < (2 + BBXyOffset); count++) {
-                output = paddingLine(paddingLineWidth, "-");
-                outputRows.push_back(output);
+            currentID = std::atoi(latestLine.c_str()
+                                  + std::min((size_t)9, latestLine.size()));
+            bool more = true;
+            while (more
+                   && strcmp(latestLine.substr(0,7).c_str(), "ENDCHAR")
+                   && strcmp(latestLine.substr(0,9).c_str(), "STARTCHAR")
+                   && strcmp(latestLine.substr(0,7).c_str(), "ENDFONT")) {
+                symbolDef.push_back(latestLine);
+                more = input.getline(latestLine);
             }
-        } else if (BBXyOffset > 0 ) { // and now add the missing
-            // whitespace for things like the tilde, carat, etc..
-            // not actually used with unifont.bdf which has full
-            // height glyph defined
-            for (int count = 0; count < BBXyOffset; count++) {
-                output = paddingLine(paddingLineWidth, "-");
-                outputRows.push_back(output);
+            if (more && !strcmp(latestLine.substr(0,7).c_str(), "ENDCHAR")) {
+                symbolDef.push_back(latestLine); // append "ENDCHAR"
             }
+            Glyph* newGlyph = new Glyph(symbolDef);
+            glyphMap.insert(std::pair<int,
+                            Glyph*>(currentID, newGlyph));
         }
     }
+    symbolDef.clear();
+    return glyphMap;
+}
 
-    vector<int8_t> generateAudio(string lastRow,
-                                 string currentRow,
-                                 string nextRow,
-                                 int rowNum) {
-        vector<int> summedAudio;
-        //    int floorFreq;
-        //    int freqSpacing;
-        //    int charLineDurationMS
-        //    int bitRate
-        int samples = ((bitRate*charLineDurationMS)/1000);// per Line
-        int taperSamples = ((bitRate*tor)/1000);
-        for (int index = 0; index < samples; index++) {
-            summedAudio.push_back(0); // zero it out
-        }
-        double deltaPhase;
-        double phaseIncrement;
-        for (int chan = 0; chan < currentRow.length(); chan++) { 
-            int currentFreq = (chan*freqSpacing + floorFreq);
-            deltaPhase = currentFreq*2*3.1417/bitRate;
-            phaseIncrement = rowNum*samples*deltaPhase;
-
-            char lastChar = '-';
-            char currentChar = currentRow[chan];
-            char nextChar = '-';
-
-            if (lastRow.length() != 0) {
-                lastChar = lastRow[chan];
-            }
+map<int, Glyph*> load_bdf_file(std::string filename,
+                               RenderStats & stats) {
+    StageTimer timer(stats.loadSeconds);
+    return parseFontLines(filename, [](auto & input) {
+            return parseBDFLines(input);
+        });
+}
 
-            if (nextRow.length() != 0) {
-                nextChar = nextRow[chan];
-            }
+// a glyph from its bare metrics and hex bitmap rows, as a BDF style
+// definition, for fonts which are not in BDF form
+static Glyph * glyphFromBitmap(int codepoint,
+                               int width,
+                               int height,
+                               int xOffset,
+                               int yOffset,
+                               int dWidth,
+                               const std::vector<string> & hexRows) {
+    std::list<std::string> symbolDef;
+    char line[64];
+    snprintf(line, sizeof(line), "STARTCHAR U+%04X", codepoint);
+    symbolDef.push_back(line);
+    snprintf(line, sizeof(line), "ENCODING %d", codepoint);
+    symbolDef.push_back(line);
+    snprintf(line, sizeof(line), "DWIDTH %d 0", dWidth);
+    symbolDef.push_back(line);
+    snprintf(line, sizeof(line), "BBX %d %d %d %d",
+             width, height, xOffset, yOffset);
+    symbolDef.push_back(line);
+    symbolDef.push_back("BITMAP");
+    symbolDef.insert(symbolDef.end(), hexRows.begin(), hexRows.end());
+    symbolDef.push_back("ENDCHAR");
+    return new Glyph(symbolDef);
+}
 
-            if ((lastChar == '#')
-                && (currentChar == '#')
-                && (nextChar == '#')) {
-                for (int sample = 0; sample < samples; sample++) {
-                    phaseIncrement += deltaPhase;
-                    summedAudio[sample]
-                        += amplitude*sin(phaseIncrement);
-                }
-            } else if ((lastChar == '-')
-                       && (currentChar == '#')
-                       && (nextChar != '#')) { // was == '-', hmm...
-                for (int sample = 0; sample < samples; sample++) {
-                    phaseIncrement += deltaPhase;
-                    summedAudio[sample]
-                        += amplitudeEnvelope(amplitude,
-                                             samples,
-                                             taperSamples,
-                                             sample,
-                                             1,
-                                             1)*sin(phaseIncrement);
-                }
-            } else if ((lastChar == '-')
-                && (currentChar == '#')
-                && (nextChar == '#')) {
-                for (int sample = 0; sample < samples; sample++) {
-                    phaseIncrement += deltaPhase;
-                    summedAudio[sample]
-                        += amplitudeEnvelope(amplitude,
-                                             samples,
-                                             taperSamples,
-                                             sample,
-                                             1,
-                                             0)*sin(phaseIncrement);
-                }
-            } else if ((lastChar == '#')
-                && (currentChar == '#')
-                && (nextChar == '-')) {
-                for (int sample = 0; sample < samples; sample++) {
-                    phaseIncrement += deltaPhase;
-                    summedAudio[sample]
-                        += amplitudeEnvelope(amplitude,
-                                             samples,
-                                             taperSamples,
-                                             sample,
-                                             0,
-                                             1)*sin(phaseIncrement);
-                }
-            }
-        }
-        vector<int8_t> returnAudio;
-        for (int index = 0; index < samples; index++) {
-            returnAudio.push_back((int8_t)(summedAudio[index]/16));
-        }
-        summedAudio.clear();
-        return returnAudio;
+template<class LineReader>
+static map<int, Glyph*> parseHexLines(LineReader & input) {
+    std::string latestLine;
+    std::map<int, Glyph*> glyphMap;
+    std::vector<string> hexRows(16);
+    while (input.getline(latestLine)) {
+        size_t colon = latestLine.find(':');
+        if (colon == string::npos) {
+            continue;
+        }
+        int codepoint = std::strtol(latestLine.c_str(), 0, 16);
+        string bitmap = latestLine.substr(colon + 1);
+        while (!bitmap.empty() && isspace((unsigned char)bitmap.back())) {
+            bitmap.erase(bitmap.length() - 1);
+        }
+        int rowDigits = bitmap.length()/16;
+        if (rowDigits == 0 || bitmap.length() % 16) {
+            continue;
+        }
+        for (int row = 0; row < 16; row++) {
+            hexRows[row] = bitmap.substr(row*rowDigits, rowDigits);
+        }
+        glyphMap.insert(std::pair<int, Glyph*>
+                        (codepoint,
+                         glyphFromBitmap(codepoint, rowDigits*4, 16, 0, -2,
+                                         rowDigits*4, hexRows)));
     }
+    return glyphMap;
+}
 
-    // we started with a simple linear ramp up and down of tone
-    // starts and tone stops in an effort to reduce splatter,
-    // now have gaussian envelope
-    static int amplitudeEnvelope(int ceiling,
-                          int totalSamples,
-                          int taperSamples,
-                          int count,
-                          int ascending,
-                          int descending) {
-        if (ascending && !descending && (count > taperSamples)) {
-            return ceiling;
-        } else if (!ascending && descending
-                   && (count < (totalSamples - taperSamples))) {
-            return ceiling;
-        } else if (ascending && !descending  
-                   && (count < taperSamples)) {
-            return (int)(ceiling*envelope[(int)((count*126)/taperSamples)]);
-        } else if (!ascending && descending
-                   && (count > (totalSamples - taperSamples))) {
-            return (int)(ceiling*envelope[((int)(((totalSamples-count)*126)/taperSamples))]);
-        } else if (ascending && descending) {
-            //            return ceiling;
-            if (count < taperSamples) {
-                return (int)(ceiling*envelope[(int)((count*126)/taperSamples)]);
-                //                return (count*ceiling)/taperSamples;
-            } else if (count < (totalSamples - taperSamples)) {
-                return ceiling;
-            } else {
-                return (int)(ceiling*envelope[((int)(((totalSamples-count)*126)/taperSamples))]);
-                //return ((totalSamples-count)*ceiling)/taperSamples;
-            }
-        } else {
-            return ceiling;
-        }
-    }
+// unifont's .hex format, i.e. "0041:0000000018242442427E424242420000",
+// with 16 rows of 8 or 16 pixels, given the same metrics as unifont's
+// BDF so that glyphs render identically from either
+map<int, Glyph*> load_hex_file(std::string filename,
+                               RenderStats & stats) {
+    StageTimer timer(stats.loadSeconds);
+    return parseFontLines(filename, [](auto & input) {
+            return parseHexLines(input);
+        });
+}
 
-    vector<int8_t> vertSymAudio() {
-        glyphInit();
-        // we ramp audio up and down into/out of the pixel(s)
-        // to do this, we need to send the previous and next line
-        string thisRow;// = outputRows[row];
-        string lastRow;// = "";
-        string nextRow;// = "";
-        symbolAudio.clear();
-        for (int row = 0; row < outputRows.size(); row++) {
-            lastRow = "";
-            thisRow = outputRows[row];
-            nextRow = "";
-            if (row > 0) {
-                lastRow = outputRows[row - 1];
-            }
-            if (row < (outputRows.size() - 1)) {
-                nextRow = outputRows[row + 1];
-            }
-            tempAudio = generateAudio(lastRow, thisRow, nextRow, row);
-            symbolAudio.insert(symbolAudio.end(),
-                               tempAudio.begin(),
-                               tempAudio.end());
-            tempAudio.clear();
-        }
-        return symbolAudio;
-    }
-    // other sym-> audio not implemented properly yet
-    vector<int8_t> leftRotSymAudio() {
-        glyphInit();
-        for (int col = paddingLineWidth; col > 0; col--) {
-            for (int row = 0; row < outputRows.size(); row++) {
-                std::cout << outputRows[row][col-1];
-            }
-            std::cout << std::endl;
-        }
-        return symbolAudio;
-    }
+const char fontSnapshotMagic[8] = {'U','2','T','F','O','N','T','1'};
 
-    vector<int8_t> rightRotSymAudio() {
-        glyphInit();
-        for (int col = 0; col < paddingLineWidth; col++) {
-            for (int row = outputRows.size(); row > 0; row--) {
-                std::cout << outputRows[row-1][col];
-            }
-            std::cout << std::endl;
-        }
-        return symbolAudio;
-    }
+// well beyond any unifont glyph, which is 16 rows of at most 2 bytes
+static const int maxSnapshotRows = 64;
+static const int maxSnapshotRowBytes = 8;
 
-    vector<int8_t> piRotatedSymAudio() {// different directions etc..
-        glyphInit();
-        for (int row = outputRows.size(); row > 0; row--) {
-            for (int col = paddingLineWidth; col > 0; col--) {
-                std::cout << outputRows[row-1][col-1];
+map<int, Glyph*> load_font_snapshot(std::string filename,
+                                    RenderStats & stats) {
+    StageTimer timer(stats.loadSeconds);
+    std::ifstream input(filename.c_str(), std::ios::binary);
+    std::map<int, Glyph*> glyphMap;
+    FontSnapshotHeader header;
+    if (!input.read((char*)&header, sizeof(header))
+        || memcmp(header.magic, fontSnapshotMagic, 8)) {
+        std::cerr << "Not a font snapshot: " << filename << std::endl;
+        return glyphMap;
+    }
+    static const char hexDigits[] = "0123456789ABCDEF";
+    std::vector<uint8_t> bitmap;
+    std::vector<string> hexRows;
+    for (uint32_t glyph = 0; glyph < header.glyphCount; glyph++) {
+        FontSnapshotRecord record;
+        bool intact = (bool)input.read((char*)&record, sizeof(record));
+        // a glyph with no bitmap at all is written as 0 by 0
+        bool empty = intact && record.height == 0 && record.rowBytes == 0;
+        intact = intact
+            && (empty || (record.height > 0
+                          && record.height <= maxSnapshotRows
+                          && record.rowBytes > 0
+                          && record.rowBytes <= maxSnapshotRowBytes))
+            && record.width >= 0 && record.width <= record.rowBytes*8;
+        if (intact) {
+            bitmap.resize(record.height*record.rowBytes);
+            intact = (bool)input.read((char*)bitmap.data(), bitmap.size());
+        }
+        if (!intact) {
+            std::cerr << "Truncated or corrupt font snapshot: " << filename
+                      << ", at glyph " << glyph << std::endl;
+            cleanUpGlyphMap(glyphMap);
+            glyphMap.clear();
+            return glyphMap;
+        }
+        hexRows.assign(record.height, "");
+        for (int row = 0; row < record.height; row++) {
+            for (int byte = 0; byte < record.rowBytes; byte++) {
+                uint8_t value = bitmap[row*record.rowBytes + byte];
+                hexRows[row] += hexDigits[value >> 4];
+                hexRows[row] += hexDigits[value & 15];
             }
-            std::cout << std::endl;
         }
-        return symbolAudio;
+        glyphMap.insert(std::pair<int, Glyph*>
+                        (record.codepoint,
+                         glyphFromBitmap(record.codepoint, record.width,
+                                         record.height, record.xOffset,
+                                         record.yOffset, record.dWidth,
+                                         hexRows)));
     }
+    return glyphMap;
+}
 
+bool hasExtension(const string & filename, const string & extension) {
+    return filename.length() >= extension.length()
+        && filename.compare(filename.length() - extension.length(),
+                            extension.length(), extension) == 0;
+}
 
-    void vertSymAscii() {
-        glyphInit();
-        for (int row = 0; row < outputRows.size(); row++) {
-            std::cout << outputRows[row] << std::endl;
-        }
-    }
-
-    void leftRotSymAscii() {
-        glyphInit();
-        for (int col = paddingLineWidth; col > 0; col--) {
-            for (int row = 0; row < outputRows.size(); row++) {
-                std::cout << outputRows[row][col-1];
-            }
-            std::cout << std::endl;
-        }
+map<int, Glyph*> load_font_file(std::string filename,
+                                RenderStats & stats) {
+    string uncompressed = uncompressedFontName(filename);
+    if (hasExtension(uncompressed, ".hex")) {
+        return load_hex_file(filename, stats);
+    } else if (hasExtension(uncompressed, ".u2f")) {
+        return load_font_snapshot(filename, stats);
     }
+    return load_bdf_file(filename, stats);
+}
 
-    void rightRotSymAscii() {
-        glyphInit();
-        for (int col = 0; col < paddingLineWidth; col++) {
-            for (int row = outputRows.size(); row > 0; row--) {
-                std::cout << outputRows[row-1][col];
-            }
-            std::cout << std::endl;
-        }
+// the glyph's audio is rendered, or copied from the cache, into the
+// context's arena, and reversed there into the order it is written
+const int8_t * renderGlyphCodeAudio(map<int, Glyph*> & glyphMap,
+                                    int glyphCode,
+                                    GlyphAudioCache * cache,
+                                    RenderContext & context,
+                                    size_t & length) {
+    map<int, Glyph*>::iterator found = glyphMap.find(glyphCode);
+    if (found == glyphMap.end() || found->second == 0) {
+        context.stats->missingGlyphs++;
+        length = 0;
+        return 0;
     }
-
-    void piRotatedSymAscii() {// different waterfall directions etc..
-        glyphInit();
-        for (int row = outputRows.size(); row > 0; row--) {
-            for (int col = paddingLineWidth; col > 0; col--) {
-                std::cout << outputRows[row-1][col-1];
-            }
-            std::cout << std::endl;
-        }
+    Glyph & glyph = *found->second;
+    if (VERBOSE) {
+        std::cout << "Generating audio for: " 
+                  << glyphCode << std::endl;
     }
-
-};
-
-
-int hexadecimalToInteger(char textChar, int power) {
-    int hexVal;
-    switch (textChar) {
-    case '0':
-        break;
-    case '1':
-        hexVal += 1*pow(16,power);
-        break;
-    case '2':
-        hexVal += 2*pow(16,power);
-        break;
-    case '3':
-        hexVal += 3*pow(16,power);
-        break;
-    case '4':
-        hexVal += 4*pow(16,power);
-        break;
-    case '5':
-        hexVal += 5*pow(16,power);
-        break;
-    case '6':
-        hexVal += 6*pow(16,power);
-        break;
-    case '7':
-        hexVal += 7*pow(16,power);
-        break;
-    case '8':
-        hexVal += 8*pow(16,power);
-        break;
-    case '9':
-        hexVal += 9*pow(16,power);
-        break;
-    case 'A':
-        hexVal += 10*pow(16,power);
-        break;
-    case 'a':
-        hexVal += 10*pow(16,power);
-        break;
-    case 'B':
-        hexVal += 11*pow(16,power);
-        break;
-    case 'b':
-        hexVal += 11*pow(16,power);
-        break;
-    case 'C':
-        hexVal += 12*pow(16,power);
-        break;
-    case 'c':
-        hexVal += 12*pow(16,power);
-        break;
-    case 'D':
-        hexVal += 13*pow(16,power);
-        break;
-    case 'd':
-        hexVal += 13*pow(16,power);
-        break;
-    case 'E':
-        hexVal += 14*pow(16,power);
-        break;
-    case 'e':
-        hexVal += 14*pow(16,power);
-        break;
-    case 'F':
-        hexVal += 15*pow(16,power);
-        break;
-    case 'f':
-        hexVal += 15*pow(16,power);
-        break;
-    default:
-        hexVal = 0;
+    context.arena.reset();
+    length = glyph.audioLength();
+    int8_t * audio = context.arena.allocate<int8_t>(length);
+    StageTimer timer(context.stats->synthesisSeconds);
+    if (cache != 0) {
+        std::shared_ptr<const vector<int8_t> > cached =
+            cache->audioFor(glyph, 'U');
+        length = cached->size();
+        std::reverse_copy(cached->begin(), cached->end(), audio);
+    } else {
+        int * scratch =
+            context.arena.allocate<int>(glyph.samplesPerRow());
+        glyph.renderVertAudio(audio, scratch);
+        std::reverse(audio, audio + length);
     }
-    return hexVal;
+    context.stats->glyphsRendered++;
+    context.stats->samplesProduced += length;
+    return audio;
 }
 
-int unicodeToInteger(string text) {
-    int hexVal;
-    hexVal = 0;
-    //std::cout << "Unicode: " << tempString << std::endl;
-    for (int textChar = 0; 
-         textChar < (text.length()-2); // skip the "U+" start
-         textChar++) {
-        if (VERBOSE) {
-            std::cout << "Processing: " 
-                      << text.at(text.length()-textChar-1) 
-                      << std::endl;
-        }
-        char c;
-        c = text.at(text.length()-textChar-1);
-        hexVal += hexadecimalToInteger(c, textChar);
+// written out in one go
+static void writeGlyphCodeToAudio(map<int, Glyph*> & glyphMap,
+                                  int glyphCode,
+                                  ofstream & fOutput,
+                                  int textNumbers,
+                                  GlyphAudioCache * cache,
+                                  RenderContext & context) {
+    size_t length;
+    const int8_t * audio = renderGlyphCodeAudio(glyphMap, glyphCode,
+                                                cache, context, length);
+    if (audio == 0) {
+        std::cerr << "Glyph "<< 
+            glyphCode << 
+            " not found in bdf file." << std::endl;
+        return;
     }
-    return hexVal;
-}
-
-
-map<int, Glyph*> load_bdf_file(std::string filename) {
-    std::string latestLine = "";
-    std::list<std::string> symbolDef;
-    std::ifstream input(filename.c_str());
-    int currentID = 0;
-    std::map<int, Glyph*> glyphMap;
-    while (getline(input, latestLine)) {
-        if (!strcmp(latestLine.substr(0,9).c_str(), "STARTCHAR")) {
-            symbolDef.clear();
-            symbolDef.push_back(latestLine); // store "STARTCHAR line"
-            getline(input, latestLine);
-            currentID = std::atoi(latestLine.substr(9).c_str());
-            while (strcmp(latestLine.substr(0,7).c_str(), "ENDCHAR")
-                   && strcmp(latestLine.substr(0,9).c_str(), "STARTCHAR")
-                   && strcmp(latestLine.substr(0,7).c_str(), "ENDFONT")) {
-                symbolDef.push_back(latestLine);
-                getline(input, latestLine);
-            }
-            if (!strcmp(latestLine.substr(0,7).c_str(), "ENDCHAR")) {
-                symbolDef.push_back(latestLine); // append "ENDCHAR"
-            }
-            Glyph* newGlyph = new Glyph(symbolDef);
-            glyphMap.insert(std::pair<int,
-                            Glyph*>(currentID, newGlyph));
+    if (VERBOSE) {
+        std::cout
+            << "About to write audio data to file of length: " 
+            << length << std::endl;
+    }
+    StageTimer timer(context.stats->writeSeconds);
+    context.stats->bytesWritten += length;
+    fOutput.write((const char*)audio, length);
+    if (textNumbers) { // in the order synthesised, i.e. unreversed
+        char buffer[33];
+        for (size_t index = length; index > 0; index--) {
+            sprintf(buffer, "%d", audio[index-1]);
+            std::cout << buffer << std::endl;
         }
     }
-    input.close();
-    symbolDef.clear();
-    return glyphMap;
 }
 
-int writeGlyphsToAudio(map<int, Glyph*> glyphMap,
+int writeGlyphsToAudio(map<int, Glyph*> & glyphMap,
                        vector<int> glyphCodes,
                        string fName,
-                       int textNumbers) {
+                       int textNumbers,
+                       GlyphAudioCache * cache,
+                       RenderContext * context) {
 
+    RenderContext localContext;
+    if (context == 0) {
+        context = &localContext;
+    }
     ofstream fOutput(fName.c_str());
-    vector<int8_t> temp;
-    char buffer[33];
     for (int index = 0; index < glyphCodes.size(); index ++) {
-        if (glyphMap[glyphCodes[index]] != 0) {
-            temp = glyphMap[glyphCodes[index]]->audioSym('U'); 
-            if (VERBOSE) {
-                std::cout << "Generating audio for: " 
-                          << glyphCodes[index] << std::endl;
-            }
-        } else {
-            std::cout << "Glyph "<< 
-                glyphCodes[index] << 
-                " not found in bdf file." << std::endl;
-            temp.clear();
-        }
-        if (VERBOSE) {
-            std::cout
-                << "About to write audio data to file of length: " 
-                << temp.size() << std::endl;
-        }
-        for (int index2 = temp.size(); index2 > 0; index2--) {
-            fOutput << (temp[index2-1]); //  << endl;
-            sprintf(buffer, "%d", temp[temp.size()-index2]);
-            if (textNumbers) {
-                std::cout << buffer << std::endl;
-            }
-        }
+        writeGlyphCodeToAudio(glyphMap, glyphCodes[index],
+                              fOutput, textNumbers, cache, *context);
     }
     fOutput.close();
-    temp.clear();
     return 0;
 }
 
-vector<int> stringToGlyphCodeVector(string textToParse,
+vector<int> stringToGlyphCodeVector(std::string_view textToParse,
                                     int extraSpaces ) {
-    string tempString = textToParse;
-    string tempString2;
-    static vector<int> glyphsToRender;
-    while (tempString.length() > 0) {
-        if ((tempString.length() < 4) ||
-            (tempString.length() == 5)) {
-            for (int index = 0; index < tempString.length(); index++) {
-                glyphsToRender.push_back((int)tempString.at(index));
-                if (VERBOSE) {
-                    std::cout << "Processing: "
-                              << tempString.at(index) << std::endl;
-                }
-                if (extraSpaces) {
-                    glyphsToRender.push_back(32); // add space
-                }
-            }
-            tempString = "";
-            if (VERBOSE) {
-                std::cout << "textToParse length: "
-                          << tempString.length() << std::endl;
-            }
-        } else if ((!strcmp(tempString.substr(0,2).c_str(), "U+") )
-                   && ((tempString.length() == 4)
-                       || (tempString.length() == 6))) {
-            glyphsToRender.push_back(unicodeToInteger(tempString));
-            tempString = "";
-            if (VERBOSE) {
-                std::cout << "textToParse length: "
-                          << tempString.length() << std::endl;
-            }
-        } else if ((!strcmp(tempString.substr(0,2).c_str(), "U+") )
-                   && (tempString.length() > 5)
-                   && (!strcmp(tempString.substr(4,2).c_str(), "U+"))) {
-            tempString2 = tempString.substr(0,4);
-            //tempString = tempString.substr(4);
-            tempString.erase(0,4);
-            if (VERBOSE) {
-                std::cout << "textToParse length: "
-                          << tempString.length() << std::endl;
-            }
-            glyphsToRender.push_back(unicodeToInteger(tempString2));
-        } else if ((!strcmp(tempString.substr(0,2).c_str(), "U+") )
-                   && (tempString.length() > 7)
-                   && (!strcmp(tempString.substr(6,2).c_str(), "U+"))) {
-            tempString2 = tempString.substr(0,6);
-            tempString.erase(0,6);
-            //tempString = tempString.substr(6);
-            glyphsToRender.push_back(unicodeToInteger(tempString2));
-        } else if ((!strcmp(tempString.substr(0,2).c_str(), "U+") )
-                   && (tempString.length() > 9)
-                   && (!strcmp(tempString.substr(8,2).c_str(), "U+"))) {
-            tempString2 = tempString.substr(0,8);
-            //tempString = tempString.substr(8);
-            tempString.erase(0,8);
-            if (VERBOSE) {
-                std::cout << "textToParse length: "
-                          << tempString.length() << std::endl;
-            }
-            glyphsToRender.push_back(unicodeToInteger(tempString2));
-        } else if ((!strcmp(tempString.substr(0,2).c_str(), "U+") )
-                   && (tempString.length() > 7)) {
-            tempString2 = tempString.substr(0,8);
-            //tempString = tempString.substr(8);
-            tempString.erase(0,8);
-            if (VERBOSE) {
-                std::cout << "textToParse length: "
-                          << tempString.length() << std::endl;
-            }
-            glyphsToRender.push_back(unicodeToInteger(tempString2));
-        } else {
-            glyphsToRender.push_back((int)tempString.at(0));
-            if (extraSpaces) {
-                glyphsToRender.push_back(32); // add space
-            }
-            //tempString = tempString.substr(1);
-            tempString.erase(0,1);
-            if (VERBOSE) {
-                std::cout << "TempString now: "
-                          << tempString << std::endl;
-            }
-        }
-     }
-    if (extraSpaces) {
-        glyphsToRender.push_back(32); // add space
+    vector<int> glyphsToRender;
+    Utf8Tokenizer tokens(textToParse, extraSpaces);
+    int codepoint;
+    while (tokens.next(codepoint)) {
+        glyphsToRender.push_back(codepoint);
     }
     if (VERBOSE) {
         std::cout << "Code vector size: " << glyphsToRender.size()
@@ -841,17 +333,27 @@ vector<int> stringToGlyphCodeVector(string textToParse,
     return glyphsToRender;
 }
 
-int writeGlyphsToAudio(map<int, Glyph*> glyphMap,
-                       string glyphString,
+int writeGlyphsToAudio(map<int, Glyph*> & glyphMap,
+                       std::string_view glyphString,
                        int extraSpaces,
                        string fName,
-                       int textNumbers) {
+                       int textNumbers,
+                       GlyphAudioCache * cache,
+                       RenderContext * context) {
 
-    return writeGlyphsToAudio(glyphMap,
-                              stringToGlyphCodeVector(glyphString,
-                                                      extraSpaces),
-                              fName,
-                              textNumbers);
+    RenderContext localContext;
+    if (context == 0) {
+        context = &localContext;
+    }
+    ofstream fOutput(fName.c_str());
+    Utf8Tokenizer tokens(glyphString, extraSpaces);
+    int codepoint;
+    while (tokens.next(codepoint)) {
+        writeGlyphCodeToAudio(glyphMap, codepoint,
+                              fOutput, textNumbers, cache, *context);
+    }
+    fOutput.close();
+    return 0;
 }
 
 
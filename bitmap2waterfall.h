@@ -0,0 +1,1064 @@
+// bitmap2waterfall.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  A utility for turning X window .bdf font description files into
+//  - ASCII depictions with up/down/left rotated/right rotated
+//    orientations
+//  - Hellschreiber audio for viewing on wterfall displays
+//  - in due course, gEDA PCB dot matrix style PCB footprints from
+//    glyphs
+//  - this allows the entire UniCode code space in the gnu Unifont
+//    to be depicted
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    bitmap2waterfall.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+
+#ifndef BITMAP2WATERFALL_H
+#define BITMAP2WATERFALL_H
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <map>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "renderStats.h"
+#include "renderArena.h"
+#include "fontStream.h"
+
+#define VERBOSE 0
+
+using namespace std;
+
+// a glyph's rendered rows as bits, with bit x of rows[y] set if the
+// pixel in column x (counting from the left) of row y is lit
+struct PackedBitmap {
+    int width;
+    int height;
+    std::vector<uint64_t> rows;
+
+    bool lit(int x, int y) const {
+        return (rows[y] >> x) & 1;
+    }
+};
+
+class Glyph {
+public:
+
+    Glyph(std::list<std::string> data,
+          int ascent = 14, 
+          int descent = 2) {
+        fontAscent = ascent;
+        fontDescent = descent;
+        glyphDef = data;
+        parsed = 0;
+        hashed = 0;
+        packed = 0;
+        floorFreq = 800;
+        freqSpacing = 17;
+        charLineDurationMS = 200; // was 10
+        bitRate = 8000;
+        nbits = 16; // not used currently 
+        amplitude = 127; //pow(2, nbits-1) - 1;
+        tor = 16;//4; // time constant for gaussian error function, ms 
+        // but for now being used to ramp tone on/off
+        pulseDuration = 0; // for gaussian error function in due course
+    }
+
+    ~Glyph() {
+        cleanUp();
+    }
+
+    void printSymSummary() {
+        glyphInit();
+        std::cout << "Summary: " << std::endl << " BBXx: "
+                  << BBXx << ", BBXy: " << BBXy << std::endl
+                  << "BBXxOffset: " << BBXxOffset
+                  << ", BBXyOffset: " << BBXyOffset << std::endl
+                  << "dispWidth:" << dispWidth << std::endl;
+    }
+ 
+    void printSym(char dir) {
+        switch (dir) {
+        case 'U':
+            vertSymAscii();
+            break;
+        case 'D':
+            piRotatedSymAscii();
+            break;
+        case 'L':
+            leftRotSymAscii();
+            break;
+        case 'R':
+            rightRotSymAscii();
+            break;            
+        }
+    }
+
+    vector<int8_t> audioSym(char dir) {
+        switch (dir) {
+        case 'U':
+            return vertSymAudio();
+        case 'D':
+            return piRotatedSymAudio();
+        case 'L':
+            return leftRotSymAudio();
+        case 'R':
+            return rightRotSymAudio();
+        }
+        return vector<int8_t>(); // no such orientation
+    }
+
+    // the rendered rows, i.e. "--#-..." strings, after parsing
+    const std::vector<string> & bitmapRows() {
+        glyphInit();
+        return outputRows;
+    }
+
+    // FNV-1a over the rendered rows, so glyphs with identical
+    // bitmaps at different codepoints hash identically
+    uint64_t bitmapHash() {
+        glyphInit();
+        if (!hashed) {
+            bitmapHashValue = 14695981039346656037ULL;
+            for (int row = 0; row < outputRows.size(); row++) {
+                for (int col = 0; col < outputRows[row].length(); col++) {
+                    bitmapHashValue ^= (unsigned char)outputRows[row][col];
+                    bitmapHashValue *= 1099511628211ULL;
+                }
+                bitmapHashValue ^= '\n';
+                bitmapHashValue *= 1099511628211ULL;
+            }
+            hashed = 1;
+        }
+        return bitmapHashValue;
+    }
+
+    // the rendered rows packed into bits, at most 64 columns wide
+    const PackedBitmap & packedBitmap() {
+        glyphInit();
+        if (!packed) {
+            packedBits.width = 0;
+            packedBits.height = outputRows.size();
+            packedBits.rows.assign(outputRows.size(), 0);
+            for (int row = 0; row < outputRows.size(); row++) {
+                int columns = outputRows[row].length();
+                if (columns > 64) {
+                    columns = 64;
+                }
+                if (columns > packedBits.width) {
+                    packedBits.width = columns;
+                }
+                for (int col = 0; col < columns; col++) {
+                    if (outputRows[row][col] == '#') {
+                        packedBits.rows[row] |= (uint64_t)1 << col;
+                    }
+                }
+            }
+            packed = 1;
+        }
+        return packedBits;
+    }
+
+    friend ostream& operator<<(ostream& output, const Glyph& g) {
+        std::list<string>::const_iterator iter;
+        //output << "Glyph definition: " << g.glyphDef.front() ;
+        for (iter = g.glyphDef.begin();
+             iter != g.glyphDef.end(); ++iter) {
+            output << *iter << std::endl;
+        }
+        return output;
+    }
+
+    std::list<std::string> glyphDef;
+    std::vector<std::string> asciiBitmap;
+    std::vector<string> outputRows;
+    std::vector<int8_t> symbolAudio;
+
+    int fontAscent;
+    int fontDescent;
+
+    int BBXx;
+    int BBXy;
+    int BBXxOffset;
+    int BBXyOffset;
+
+    int dispWidth;
+    int paddingLineWidth;
+
+    int floorFreq;
+    int freqSpacing;
+    int charLineDurationMS;
+    int bitRate;
+    int nbits;
+    int amplitude;
+
+    bool parsed;
+    bool hashed;
+    uint64_t bitmapHashValue;
+    bool packed;
+    PackedBitmap packedBits;
+
+    string whitespace;
+    string currentLine; 
+    string currentRow;
+    string output;
+
+    int tor; // time constant for gaussian error function, ms 
+    int pulseDuration;
+
+    static const double envelope[];
+    
+private:
+    
+   void cleanUp() {
+        glyphDef.clear();
+        asciiBitmap.clear();
+        outputRows.clear();
+    }
+
+    static string padding(int num, string pad) {
+        if (num < 1 ) { // i.e. if BBXxOffset < 1, we do nothing
+            return "";
+        } else {
+            return pad + padding(num-1, pad);
+        }
+    }
+
+    string paddingLine(int num, string pad) {
+        whitespace = "";
+        if (BBXx < dispWidth) {
+            num = dispWidth;
+        }
+        if (BBXxOffset > 0) {
+            num += BBXxOffset;
+        }
+        for (int count = 0; count < num; count++) {
+            whitespace = whitespace + pad;
+        }
+        return whitespace;
+    }
+
+    void glyphInit() {
+        if (parsed == 0) {
+            parseDef();
+            parsed = 1;
+        }
+    }
+
+    void parseDef() {
+        list<std::string>::iterator it1, it2;
+        it1 = glyphDef.begin();
+        it2 = glyphDef.end(); //ignore "ENDCHAR"
+        int index1 = 0;
+        int index2 = 0;
+        for (; it1 != it2; it1++) {
+            currentLine = *it1;
+            if (!strcmp(currentLine.substr(0,4).c_str(), "BBX ")) {
+                index1 = index2 = 4;
+                while (currentLine[index2] != ' ') {
+                    index2++;
+                }
+                BBXx = 
+                    std::atoi(currentLine.substr(index1, index2-1).c_str());
+                index1 = index2;
+                index2++;
+                while (currentLine[index2] != ' ') {
+                    index2++;
+                }
+                BBXy = 
+                    std::atoi(currentLine.substr(index1, index2-1).c_str());
+                index1 = index2;
+                index2++;
+                while (currentLine[index2] != ' ') {
+                    index2++;
+                }
+                BBXxOffset = 
+                    std::atoi(currentLine.substr(index1, index2-1).c_str());
+                index1 = index2;
+                BBXyOffset = 
+                    std::atoi(currentLine.substr(index1).c_str());
+            } else if (!strcmp(currentLine.substr(0,7).c_str(), "DWIDTH ")) {
+                index1 = index2 = 7;
+                while (currentLine[index2] != ' ') {
+                    index2++;
+                }
+                dispWidth = 
+                    std::atoi(currentLine.substr(index1, index2-1).c_str());
+            } else if (!strcmp(currentLine.substr(0,6).c_str(), "BITMAP")) {
+                // we move onto the next line, into the bitmapping
+                for (it1++; it1 != it2; it1++) {
+                    currentLine = *it1;
+                    if (strcmp(currentLine.substr(0,7).c_str(), "ENDCHAR")) {
+                        asciiBitmap.push_back(currentLine);
+                    }
+                }
+                // now sort out the outer for loop
+                if (it1 == it2) {
+                    it1--;
+                }
+            }
+        }
+        parsed = 1;
+        processBitmap();
+    }
+
+    void processBitmap() {
+
+        paddingLineWidth = asciiBitmap[0].length()*4;
+
+        if (BBXxOffset < 0) {
+            paddingLineWidth -= BBXxOffset;
+        } else {
+            paddingLineWidth += BBXxOffset;
+        }
+
+        // this is helpful for firefly bdf but not crucial
+        // for unifont.bdf which has uniform glyph heights
+        if (BBXyOffset < 0 ) {
+            for (int count = 0; count > BBXyOffset; count--) {
+                output = paddingLine(paddingLineWidth, "-");
+                outputRows.push_back(output);
+            }
+        }
+
+        // could do (fontAscent - glyphHeight) padding
+        // rows here I think but unifont.bdf
+        // is well behaved WRT BBX height=16 for all glyphs 
+        for (int index = 0; index < BBXy; index++) {
+            currentRow = asciiBitmap[index];
+            output = ""; // zero it out
+            for (int column = 0;
+                 column < currentRow.length(); column++) {
+                switch (currentRow[column]) {
+                case '0':
+                    output = output + "----";
+                    break;
+                case '1':
+                    output = output + "---#";
+                    break;
+                case '2':
+                    output = output + "--#-";
+                    break;
+                case '3':
+                    output = output + "--##";
+                    break;
+                case '4':
+                    output = output + "-#--";
+                    break;
+                case '5':
+                    output = output + "-#-#";
+                    break;
+                case '6':
+                    output = output + "-##-";
+                    break;
+                case '7':
+                    output = output + "-###";
+                    break;
+                case '8':
+                    output = output + "#---";
+                    break;
+                case '9':
+                    output = output + "#--#";
+                    break;
+                case 'A':
+                    output = output + "#-#-";
+                    break;
+                case 'B':
+                    output = output + "#-##";
+                    break;
+                case 'C':
+                    output = output + "##--";
+                    break;
+                case 'D':
+                    output = output + "##-#";
+                    break;
+                case 'E':
+                    output = output + "###-";
+                    break;
+                case 'F':
+                    output = output + "####";
+                    break;
+                }
+            }
+            output = padding(BBXxOffset, "-") + output;
+            outputRows.push_back(output);
+            output = "";
+        }
+        if (BBXy < 16){// we do this to sort out descending and
+            // ascending limbs, such as on l, k, q, p etc...
+            // not actually used with unifont.bdf
+            for (int count = 0; // (+2 - BBXyOffset) is about right
+                 // this is the "FONT_DESCENT" in the bdf
+                 count < (2 + BBXyOffset); count++) {
+                output = paddingLine(paddingLineWidth, "-");
+                outputRows.push_back(output);
+            }
+        } else if (BBXyOffset > 0 ) { // and now add the missing
+            // whitespace for things like the tilde, carat, etc..
+            // not actually used with unifont.bdf which has full
+            // height glyph defined
+            for (int count = 0; count < BBXyOffset; count++) {
+                output = paddingLine(paddingLineWidth, "-");
+                outputRows.push_back(output);
+            }
+        }
+    }
+
+public:
+
+    // synthesises one row of the glyph, with the previous and next
+    // rows ("" if none) deciding how each tone is ramped on and off
+    vector<int8_t> generateAudio(string lastRow,
+                                 string currentRow,
+                                 string nextRow,
+                                 int rowNum) {
+        vector<int> summedAudio(samplesPerRow());
+        vector<int8_t> returnAudio(samplesPerRow());
+        generateAudio(lastRow, currentRow, nextRow, rowNum,
+                      returnAudio.data(), summedAudio.data());
+        return returnAudio;
+    }
+
+    // as above, but writing samplesPerRow() samples in place into
+    // out, using summedAudio (also samplesPerRow() long) as scratch
+    void generateAudio(const string & lastRow,
+                       const string & currentRow,
+                       const string & nextRow,
+                       int rowNum,
+                       int8_t * out,
+                       int * summedAudio) {
+        //    int floorFreq;
+        //    int freqSpacing;
+        //    int charLineDurationMS
+        //    int bitRate
+        int samples = samplesPerRow();
+        int taperSamples = ((bitRate*tor)/1000);
+        for (int index = 0; index < samples; index++) {
+            summedAudio[index] = 0; // zero it out
+        }
+        double deltaPhase;
+        double phaseIncrement;
+        for (int chan = 0; chan < currentRow.length(); chan++) { 
+            int currentFreq = (chan*freqSpacing + floorFreq);
+            deltaPhase = currentFreq*2*3.1417/bitRate;
+            // phase runs on continuously from row to row, but starts
+            // afresh at the first row of each glyph, so a glyph's audio
+            // does not depend on whatever was sent before it
+            phaseIncrement = rowNum*samples*deltaPhase;
+
+            char lastChar = '-';
+            char currentChar = currentRow[chan];
+            char nextChar = '-';
+
+            if (lastRow.length() != 0) {
+                lastChar = lastRow[chan];
+            }
+
+            if (nextRow.length() != 0) {
+                nextChar = nextRow[chan];
+            }
+
+            if ((lastChar == '#')
+                && (currentChar == '#')
+                && (nextChar == '#')) {
+                for (int sample = 0; sample < samples; sample++) {
+                    phaseIncrement += deltaPhase;
+                    summedAudio[sample]
+                        += amplitude*sin(phaseIncrement);
+                }
+            } else if ((lastChar == '-')
+                       && (currentChar == '#')
+                       && (nextChar != '#')) { // was == '-', hmm...
+                for (int sample = 0; sample < samples; sample++) {
+                    phaseIncrement += deltaPhase;
+                    summedAudio[sample]
+                        += amplitudeEnvelope(amplitude,
+                                             samples,
+                                             taperSamples,
+                                             sample,
+                                             1,
+                                             1)*sin(phaseIncrement);
+                }
+            } else if ((lastChar == '-')
+                && (currentChar == '#')
+                && (nextChar == '#')) {
+                for (int sample = 0; sample < samples; sample++) {
+                    phaseIncrement += deltaPhase;
+                    summedAudio[sample]
+                        += amplitudeEnvelope(amplitude,
+                                             samples,
+                                             taperSamples,
+                                             sample,
+                                             1,
+                                             0)*sin(phaseIncrement);
+                }
+            } else if ((lastChar == '#')
+                && (currentChar == '#')
+                && (nextChar == '-')) {
+                for (int sample = 0; sample < samples; sample++) {
+                    phaseIncrement += deltaPhase;
+                    summedAudio[sample]
+                        += amplitudeEnvelope(amplitude,
+                                             samples,
+                                             taperSamples,
+                                             sample,
+                                             0,
+                                             1)*sin(phaseIncrement);
+                }
+            }
+        }
+        for (int index = 0; index < samples; index++) {
+            out[index] = (int8_t)(summedAudio[index]/16);
+        }
+    }
+
+    int samplesPerRow() const {
+        return ((bitRate*charLineDurationMS)/1000);
+    }
+
+    // samples in the glyph's upright (vertSymAudio) audio
+    size_t audioLength() {
+        glyphInit();
+        return outputRows.size()*samplesPerRow();
+    }
+
+    // the upright audio written straight into out, which must hold
+    // audioLength() samples, with scratch holding samplesPerRow()
+    void renderVertAudio(int8_t * out, int * scratch) {
+        glyphInit();
+        static const string noRow = "";
+        int samples = samplesPerRow();
+        for (int row = 0; row < outputRows.size(); row++) {
+            const string & lastRow = (row > 0) ? outputRows[row - 1] : noRow;
+            const string & nextRow = (row < (outputRows.size() - 1))
+                ? outputRows[row + 1] : noRow;
+            generateAudio(lastRow, outputRows[row], nextRow, row,
+                          out + row*samples, scratch);
+        }
+    }
+
+private:
+
+    // we started with a simple linear ramp up and down of tone
+    // starts and tone stops in an effort to reduce splatter,
+    // now have gaussian envelope
+    static int amplitudeEnvelope(int ceiling,
+                          int totalSamples,
+                          int taperSamples,
+                          int count,
+                          int ascending,
+                          int descending) {
+        if (ascending && !descending && (count > taperSamples)) {
+            return ceiling;
+        } else if (!ascending && descending
+                   && (count < (totalSamples - taperSamples))) {
+            return ceiling;
+        } else if (ascending && !descending  
+                   && (count < taperSamples)) {
+            return (int)(ceiling*envelope[(int)((count*126)/taperSamples)]);
+        } else if (!ascending && descending
+                   && (count > (totalSamples - taperSamples))) {
+            return (int)(ceiling*envelope[((int)(((totalSamples-count)*126)/taperSamples))]);
+        } else if (ascending && descending) {
+            //            return ceiling;
+            if (count < taperSamples) {
+                return (int)(ceiling*envelope[(int)((count*126)/taperSamples)]);
+                //                return (count*ceiling)/taperSamples;
+            } else if (count < (totalSamples - taperSamples)) {
+                return ceiling;
+            } else {
+                return (int)(ceiling*envelope[((int)(((totalSamples-count)*126)/taperSamples))]);
+                //return ((totalSamples-count)*ceiling)/taperSamples;
+            }
+        } else {
+            return ceiling;
+        }
+    }
+
+    vector<int8_t> vertSymAudio() {
+        // we ramp audio up and down into/out of the pixel(s)
+        // to do this, we need to send the previous and next line
+        vector<int> scratch(samplesPerRow());
+        symbolAudio.resize(audioLength());
+        renderVertAudio(symbolAudio.data(), scratch.data());
+        return symbolAudio;
+    }
+    // other sym-> audio not implemented properly yet
+    vector<int8_t> leftRotSymAudio() {
+        glyphInit();
+        for (int col = paddingLineWidth; col > 0; col--) {
+            for (int row = 0; row < outputRows.size(); row++) {
+                std::cout << outputRows[row][col-1];
+            }
+            std::cout << std::endl;
+        }
+        return symbolAudio;
+    }
+
+    vector<int8_t> rightRotSymAudio() {
+        glyphInit();
+        for (int col = 0; col < paddingLineWidth; col++) {
+            for (int row = outputRows.size(); row > 0; row--) {
+                std::cout << outputRows[row-1][col];
+            }
+            std::cout << std::endl;
+        }
+        return symbolAudio;
+    }
+
+    vector<int8_t> piRotatedSymAudio() {// different directions etc..
+        glyphInit();
+        for (int row = outputRows.size(); row > 0; row--) {
+            for (int col = paddingLineWidth; col > 0; col--) {
+                std::cout << outputRows[row-1][col-1];
+            }
+            std::cout << std::endl;
+        }
+        return symbolAudio;
+    }
+
+
+    void vertSymAscii() {
+        glyphInit();
+        for (int row = 0; row < outputRows.size(); row++) {
+            std::cout << outputRows[row] << std::endl;
+        }
+    }
+
+    void leftRotSymAscii() {
+        glyphInit();
+        for (int col = paddingLineWidth; col > 0; col--) {
+            for (int row = 0; row < outputRows.size(); row++) {
+                std::cout << outputRows[row][col-1];
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    void rightRotSymAscii() {
+        glyphInit();
+        for (int col = 0; col < paddingLineWidth; col++) {
+            for (int row = outputRows.size(); row > 0; row--) {
+                std::cout << outputRows[row-1][col];
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    void piRotatedSymAscii() {// different waterfall directions etc..
+        glyphInit();
+        for (int row = outputRows.size(); row > 0; row--) {
+            for (int col = paddingLineWidth; col > 0; col--) {
+                std::cout << outputRows[row-1][col-1];
+            }
+            std::cout << std::endl;
+        }
+    }
+
+};
+
+
+// glyph audio depends only on the rendered bitmap and the tone
+// parameters, so we cache it by content rather than by codepoint;
+// repeated characters, and the many codepoints in unifont which
+// share a bitmap (spaces, compatibility forms etc...), are then
+// synthesised just once. Least recently used entries are dropped
+// once the cached audio exceeds maxBytes.
+class GlyphAudioCache {
+public:
+
+    GlyphAudioCache(size_t maxBytes = 64*1024*1024) {
+        capacityBytes = maxBytes;
+        bytesUsed = 0;
+        hits = 0;
+        misses = 0;
+        evictions = 0;
+        stats = &renderStats;
+    }
+
+    // hits and misses are also counted in stats, renderStats otherwise
+    void countInto(RenderStats & counters) {
+        stats = &counters;
+    }
+
+    // the returned audio is shared with the cache and stays valid
+    // after eviction for as long as the caller holds on to it
+    std::shared_ptr<const vector<int8_t> > audioFor(Glyph & glyph,
+                                                    char dir = 'U') {
+        CacheKey key = keyFor(glyph, dir);
+        uint64_t hash = key.hash();
+        std::unordered_map<uint64_t, EntryList::iterator>::iterator
+            found = index.find(hash);
+        if (found != index.end()
+            && found->second->key == key
+            && found->second->rows == glyph.bitmapRows()) {
+            hits++;
+            stats->cacheHits++;
+            entries.splice(entries.begin(), entries, found->second);
+            return found->second->audio;
+        }
+        misses++;
+        stats->cacheMisses++;
+        std::shared_ptr<const vector<int8_t> > audio;
+        if (dir == 'U') { // rendered straight into the entry
+            std::shared_ptr<vector<int8_t> > rendered =
+                std::make_shared<vector<int8_t> >(glyph.audioLength());
+            scratch.resize(glyph.samplesPerRow());
+            glyph.renderVertAudio(rendered->data(), scratch.data());
+            audio = rendered;
+        } else {
+            audio = std::make_shared<const vector<int8_t> >(glyph.audioSym(dir));
+        }
+        if (found != index.end()) { // a hash collision, keep the old
+            return audio;
+        }
+        if (audio->size() > capacityBytes) {
+            return audio;
+        }
+        Entry entry;
+        entry.key = key;
+        entry.rows = glyph.bitmapRows();
+        entry.audio = audio;
+        entries.push_front(entry);
+        index[hash] = entries.begin();
+        bytesUsed += audio->size();
+        while (bytesUsed > capacityBytes) {
+            evictOldest();
+        }
+        return audio;
+    }
+
+    void clear() {
+        entries.clear();
+        index.clear();
+        bytesUsed = 0;
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    size_t capacityBytes;
+    size_t bytesUsed;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    RenderStats * stats;
+
+private:
+
+    struct CacheKey {
+        uint64_t bitmap;
+        char dir;
+        int floorFreq;
+        int freqSpacing;
+        int charLineDurationMS;
+        int bitRate;
+        int amplitude;
+        int tor;
+
+        bool operator==(const CacheKey & other) const {
+            return bitmap == other.bitmap && dir == other.dir
+                && floorFreq == other.floorFreq
+                && freqSpacing == other.freqSpacing
+                && charLineDurationMS == other.charLineDurationMS
+                && bitRate == other.bitRate
+                && amplitude == other.amplitude
+                && tor == other.tor;
+        }
+
+        uint64_t hash() const {
+            uint64_t h = bitmap;
+            int params[] = {dir, floorFreq, freqSpacing,
+                            charLineDurationMS, bitRate, amplitude, tor};
+            for (int index = 0; index < 7; index++) {
+                h ^= (uint64_t)(uint32_t)params[index];
+                h *= 1099511628211ULL;
+            }
+            return h;
+        }
+    };
+
+    struct Entry {
+        CacheKey key;
+        std::vector<string> rows; // to rule out hash collisions
+        std::shared_ptr<const vector<int8_t> > audio;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    static CacheKey keyFor(Glyph & glyph, char dir) {
+        CacheKey key;
+        key.bitmap = glyph.bitmapHash();
+        key.dir = dir;
+        key.floorFreq = glyph.floorFreq;
+        key.freqSpacing = glyph.freqSpacing;
+        key.charLineDurationMS = glyph.charLineDurationMS;
+        key.bitRate = glyph.bitRate;
+        key.amplitude = glyph.amplitude;
+        key.tor = glyph.tor;
+        return key;
+    }
+
+    void evictOldest() {
+        Entry & oldest = entries.back();
+        bytesUsed -= oldest.audio->size();
+        index.erase(oldest.key.hash());
+        entries.pop_back();
+        evictions++;
+    }
+
+    vector<int> scratch;
+    EntryList entries; // most recently used at the front
+    std::unordered_map<uint64_t, EntryList::iterator> index;
+};
+
+
+// single pass tokenizer over the text to be rendered, which
+// decodes UTF-8 and "U+XXXX" style escapes of between one and six
+// hex digits, handing codepoints out one at a time via next()
+// so that nothing but the string_view itself is held
+class Utf8Tokenizer {
+public:
+
+    Utf8Tokenizer(std::string_view text,
+                  int extraSpaces = 0,
+                  RenderStats & counters = renderStats) {
+        remaining = text;
+        addSpaces = extraSpaces;
+        spacePending = 0;
+        finished = 0;
+        stats = &counters;
+        timed = true;
+    }
+
+    // for a scan which isn't the tokenize stage, i.e. finding which
+    // fonts a message needs, so that the message is only timed once
+    void untimed() {
+        timed = false;
+    }
+
+    bool next(int & codepoint) {
+        StageTimer timer(stats->tokenizeSeconds, timed);
+        if (spacePending) {
+            spacePending = 0;
+            codepoint = 32;
+            return true;
+        }
+        if (remaining.empty()) {
+            if (addSpaces && !finished) { // trailing space, as before
+                finished = 1;
+                codepoint = 32;
+                return true;
+            }
+            return false;
+        }
+        if (parseEscape(codepoint)) {
+            return true;
+        }
+        codepoint = decodeUtf8();
+        if (addSpaces) {
+            spacePending = 1;
+        }
+        if (VERBOSE) {
+            std::cout << "Processing: " << codepoint << std::endl;
+        }
+        return true;
+    }
+
+    static const int replacementChar = 0xFFFD;
+
+private:
+
+    std::string_view remaining;
+    int addSpaces;
+    int spacePending;
+    int finished;
+    RenderStats * stats;
+    bool timed;
+
+    static int hexDigitValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        } else if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        } else if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    // "U+" followed by up to six hex digits; a "U+" with no
+    // digits after it is left to be rendered as plain text
+    bool parseEscape(int & codepoint) {
+        if (remaining.size() < 3
+            || remaining[0] != 'U'
+            || remaining[1] != '+'
+            || hexDigitValue(remaining[2]) < 0) {
+            return false;
+        }
+        int value = 0;
+        size_t index = 2;
+        while (index < remaining.size() && index < 8
+               && hexDigitValue(remaining[index]) >= 0) {
+            value = value*16 + hexDigitValue(remaining[index]);
+            index++;
+        }
+        remaining.remove_prefix(index);
+        codepoint = (value > 0x10FFFF) ? replacementChar : value;
+        if (VERBOSE) {
+            std::cout << "Unicode escape: " << codepoint << std::endl;
+        }
+        return true;
+    }
+
+    // malformed sequences, overlong forms and surrogates each
+    // produce a single U+FFFD and we resynchronise on the next byte
+    int decodeUtf8() {
+        unsigned char lead = remaining[0];
+        int length;
+        int value;
+        int minimum;
+        if (lead < 0x80) {
+            remaining.remove_prefix(1);
+            return lead;
+        } else if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            value = lead & 0x1F;
+            minimum = 0x80;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            value = lead & 0x0F;
+            minimum = 0x800;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            value = lead & 0x07;
+            minimum = 0x10000;
+        } else {
+            remaining.remove_prefix(1);
+            return replacementChar;
+        }
+        if (remaining.size() < (size_t)length) {
+            remaining.remove_prefix(1);
+            return replacementChar;
+        }
+        for (int index = 1; index < length; index++) {
+            unsigned char continuation = remaining[index];
+            if ((continuation & 0xC0) != 0x80) {
+                remaining.remove_prefix(1);
+                return replacementChar;
+            }
+            value = (value << 6) | (continuation & 0x3F);
+        }
+        remaining.remove_prefix(length);
+        if (value < minimum || value > 0x10FFFF
+            || (value >= 0xD800 && value <= 0xDFFF)) {
+            return replacementChar;
+        }
+        return value;
+    }
+};
+
+// the loaders read .gz and .xz compressed fonts as well
+// the load time goes to stats
+map<int, Glyph*> load_bdf_file(std::string filename,
+                               RenderStats & stats = renderStats);
+
+// unifont's .hex format, i.e. "0041:0000000018242442427E424242420000"
+map<int, Glyph*> load_hex_file(std::string filename,
+                               RenderStats & stats = renderStats);
+
+// The compact binary font snapshot, in host byte order:
+//
+//    FontSnapshotHeader
+//    glyphCount times:
+//        FontSnapshotRecord
+//        height*rowBytes bytes of bitmap, one row after another
+extern const char fontSnapshotMagic[8];
+
+struct FontSnapshotHeader {
+    char magic[8];
+    uint32_t glyphCount;
+};
+
+struct FontSnapshotRecord {
+    int32_t codepoint;
+    int16_t width;
+    int16_t height;
+    int16_t xOffset;
+    int16_t yOffset;
+    int16_t dWidth;
+    uint16_t rowBytes;
+};
+
+map<int, Glyph*> load_font_snapshot(std::string filename,
+                                    RenderStats & stats = renderStats);
+
+bool hasExtension(const string & filename, const string & extension);
+
+// picks the loader by extension, less any .gz or .xz, BDF being the
+// default
+map<int, Glyph*> load_font_file(std::string filename,
+                                RenderStats & stats = renderStats);
+
+// the glyph's audio, in the order it is written to file, rendered into
+// the context's arena, or 0 if the glyph is not in the map
+const int8_t * renderGlyphCodeAudio(map<int, Glyph*> & glyphMap,
+                                    int glyphCode,
+                                    GlyphAudioCache * cache,
+                                    RenderContext & context,
+                                    size_t & length);
+
+int writeGlyphsToAudio(map<int, Glyph*> & glyphMap,
+                       vector<int> glyphCodes,
+                       string fName,
+                       int textNumbers,
+                       GlyphAudioCache * cache = 0,
+                       RenderContext * context = 0);
+
+vector<int> stringToGlyphCodeVector(std::string_view textToParse,
+                                    int extraSpaces );
+
+// codepoints are pulled from the tokenizer as they are rendered,
+// rather than being collected into a vector first
+int writeGlyphsToAudio(map<int, Glyph*> & glyphMap,
+                       std::string_view glyphString,
+                       int extraSpaces,
+                       string fName,
+                       int textNumbers,
+                       GlyphAudioCache * cache = 0,
+                       RenderContext * context = 0);
+
+int cleanUpGlyphMap(map<int, Glyph*> theMap);
+
+#endif
@@ -0,0 +1,103 @@
+// capiTest.c v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Checks the plain C interface of libunifont2things from C: that a
+//  message renders the same into a buffer as through the callback,
+//  and that the renderer's stats account for it, writing included.
+//
+//  Usage: make test
+//     or: ./capiTest font.hex
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//    capiTest.c (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "unifont2things.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char message[] = "CQ CQ de VK5 U+262F";
+
+struct callbackCheck {
+    const int8_t * expected;
+    size_t offset;
+    int differs;
+};
+
+static void compareAudio(const int8_t * samples, size_t count, void * user) {
+    struct callbackCheck * check = (struct callbackCheck *)user;
+    if (memcmp(check->expected + check->offset, samples, count) != 0) {
+        check->differs = 1;
+    }
+    check->offset += count;
+}
+
+static int failures = 0;
+
+static void expect(int passed, const char * what) {
+    if (!passed) {
+        fprintf(stderr, "capiTest failed: %s\n", what);
+        failures++;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: capiTest font\n");
+        return 1;
+    }
+    const char * fonts[] = {argv[1]};
+    const char * missing[] = {"no such font.bdf"};
+    expect(u2t_open(fonts, 0) == NULL, "u2t_open with no fonts");
+    expect(u2t_open(missing, 1) == NULL, "u2t_open with a missing font");
+
+    u2t_renderer * renderer = u2t_open(fonts, 1);
+    if (renderer == NULL) {
+        fprintf(stderr, "capiTest failed: unable to open %s\n", argv[1]);
+        return 1;
+    }
+    long samples = u2t_render(renderer, message, NULL, 0);
+    expect(samples > 0, "u2t_render measures the message");
+    int8_t * audio = malloc(samples > 0 ? samples : 1);
+    u2t_reset_stats(renderer);
+    expect(u2t_render(renderer, message, audio, samples) == samples,
+           "u2t_render fills the buffer");
+
+    u2t_stats stats;
+    u2t_get_stats(renderer, &stats);
+    expect(stats.glyphs_rendered > 0, "glyphs_rendered after u2t_render");
+    expect(stats.samples_produced == (unsigned long long)samples,
+           "samples_produced after u2t_render");
+    expect(stats.bytes_written == (unsigned long long)samples,
+           "bytes_written after u2t_render");
+
+    struct callbackCheck check = {audio, 0, 0};
+    expect(u2t_render_cb(renderer, message, compareAudio, &check) == 0,
+           "u2t_render_cb succeeds");
+    expect(!check.differs && check.offset == (size_t)samples,
+           "u2t_render_cb matches u2t_render");
+    u2t_get_stats(renderer, &stats);
+    expect(stats.bytes_written == 2*(unsigned long long)samples,
+           "bytes_written after u2t_render_cb");
+
+    free(audio);
+    u2t_close(renderer);
+    return failures ? 1 : 0;
+}
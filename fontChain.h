@@ -0,0 +1,123 @@
+// fontChain.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  An ordered list of fonts, i.e. firefly for Latin falling back to
+//  unifont for everything else, behind a single merged index
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    fontChain.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef FONTCHAIN_H
+#define FONTCHAIN_H
+
+#include <set>
+#include "bitmap2waterfall.h"
+
+// Fonts are loaded in order, and only when a lookup misses in all
+// of the fonts loaded so far, so a fallback is never loaded unless
+// something actually needs it. As each font is loaded its glyphs
+// are merged into the index, without displacing those of earlier
+// fonts, so any lookup is then a single probe of the index. The
+// index is an ordinary glyph map, so it can be handed straight to
+// writeGlyphsToAudio() and friends.
+class FontChain {
+public:
+
+    // load times are counted in stats
+    FontChain(std::vector<string> fontFiles,
+              RenderStats & counters = renderStats) {
+        files = fontFiles;
+        fontsLoaded = 0;
+        stats = &counters;
+    }
+
+    ~FontChain() {
+        for (int font = 0; font < fonts.size(); font++) {
+            cleanUpGlyphMap(fonts[font]);
+        }
+    }
+
+    // 0 if none of the fonts has the codepoint
+    Glyph * lookup(int codepoint) {
+        map<int, Glyph*>::iterator found = index.find(codepoint);
+        if (found != index.end()) {
+            return found->second;
+        }
+        if (missing.count(codepoint)) {
+            return 0;
+        }
+        while (fontsLoaded < files.size()) {
+            loadNextFont();
+            found = index.find(codepoint);
+            if (found != index.end()) {
+                return found->second;
+            }
+        }
+        missing.insert(codepoint);
+        return 0;
+    }
+
+    // the index, with whichever fonts the text needs loaded
+    map<int, Glyph*> & glyphsFor(std::string_view text) {
+        if (fontsLoaded == 0 && !files.empty()) {
+            loadNextFont();
+        }
+        Utf8Tokenizer tokens(text, 0, *stats);
+        tokens.untimed(); // the writer's tokenizer times the message
+        int codepoint;
+        while (tokens.next(codepoint)) {
+            lookup(codepoint);
+        }
+        return index;
+    }
+
+    // the index, with every font loaded
+    map<int, Glyph*> & allGlyphs() {
+        while (fontsLoaded < files.size()) {
+            loadNextFont();
+        }
+        return index;
+    }
+
+    int loadedFontCount() const {
+        return fontsLoaded;
+    }
+
+private:
+
+    void loadNextFont() {
+        fonts.push_back(load_font_file(files[fontsLoaded], *stats));
+        fontsLoaded++;
+        index.insert(fonts.back().begin(), fonts.back().end());
+        missing.clear(); // may now be found
+    }
+
+    std::vector<string> files;
+    std::vector<map<int, Glyph*> > fonts;
+    int fontsLoaded;
+    map<int, Glyph*> index;
+    std::set<int> missing;
+    RenderStats * stats;
+
+    FontChain(const FontChain &);
+    FontChain & operator=(const FontChain &);
+};
+
+#endif
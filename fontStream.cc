@@ -0,0 +1,235 @@
+// fontStream.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Line readers for the font loaders, over plain files or, with
+//  decompression running on a thread of its own, .gz and .xz files
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    fontStream.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "fontStream.h"
+#include <cstdio>
+#include <cstring>
+#include <zlib.h>
+#include <lzma.h>
+
+static bool endsWith(const string & filename, const char * extension) {
+    size_t length = strlen(extension);
+    return filename.length() > length
+        && filename.compare(filename.length() - length, length,
+                            extension) == 0;
+}
+
+bool compressedFontFile(const string & filename) {
+    return endsWith(filename, ".gz") || endsWith(filename, ".xz");
+}
+
+string uncompressedFontName(const string & filename) {
+    return compressedFontFile(filename)
+        ? filename.substr(0, filename.length() - 3) : filename;
+}
+
+DecompressingLineReader::DecompressingLineReader(string filename,
+                                                 size_t chunkBytes,
+                                                 int queueDepth)
+    : filename(filename), chunkBytes(chunkBytes),
+      queueDepth(queueDepth > 0 ? queueDepth : 1) {
+    finished = false;
+    stopping = false;
+    position = 0;
+    if (endsWith(filename, ".xz")) {
+        worker = std::thread(&DecompressingLineReader::decompressXz, this);
+    } else {
+        worker = std::thread(&DecompressingLineReader::decompressGzip, this);
+    }
+}
+
+DecompressingLineReader::~DecompressingLineReader() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+string DecompressingLineReader::error() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return failure;
+}
+
+bool DecompressingLineReader::publish(std::vector<char> & chunk) {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] {
+            return stopping || ready.size() < queueDepth;
+        });
+    if (stopping) {
+        return false;
+    }
+    ready.push_back(std::move(chunk));
+    if (!spare.empty()) {
+        chunk = std::move(spare.back());
+        spare.pop_back();
+    }
+    chunk.resize(0);
+    guard.unlock();
+    changed.notify_all();
+    return true;
+}
+
+void DecompressingLineReader::finish(string error) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        finished = true;
+        failure = error;
+    }
+    changed.notify_all();
+}
+
+bool DecompressingLineReader::nextChunk() {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] {
+            return finished || !ready.empty();
+        });
+    if (ready.empty()) {
+        return false;
+    }
+    spare.push_back(std::move(current));
+    current = std::move(ready.front());
+    ready.pop_front();
+    position = 0;
+    guard.unlock();
+    changed.notify_all();
+    return true;
+}
+
+bool DecompressingLineReader::getline(string & line) {
+    line.clear();
+    bool any = false;
+    while (true) {
+        if (position < current.size()) {
+            any = true;
+            const char * start = current.data() + position;
+            const char * newline =
+                (const char*)memchr(start, '\n', current.size() - position);
+            if (newline != 0) {
+                line.append(start, newline - start);
+                position += newline - start + 1;
+                return true;
+            }
+            line.append(start, current.size() - position);
+            position = current.size();
+        }
+        if (!nextChunk()) {
+            return any; // a last line without a newline still counts
+        }
+    }
+}
+
+// zlib's message, less the file name it starts with
+static string gzipError(gzFile input, const string & filename) {
+    int code;
+    string error = gzerror(input, &code);
+    if (code == Z_OK) {
+        return "";
+    }
+    if (error.compare(0, filename.length() + 2, filename + ": ") == 0) {
+        error.erase(0, filename.length() + 2);
+    }
+    return error;
+}
+
+void DecompressingLineReader::decompressGzip() {
+    gzFile input = gzopen(filename.c_str(), "rb");
+    if (input == 0) {
+        finish("unable to open");
+        return;
+    }
+    gzbuffer(input, 128*1024);
+    std::vector<char> chunk;
+    string error;
+    while (true) {
+        chunk.resize(chunkBytes);
+        int got = gzread(input, chunk.data(), chunkBytes);
+        if (got <= 0) {
+            // zlib only owns up to a truncated file at the end
+            error = gzipError(input, filename);
+            break;
+        }
+        chunk.resize(got);
+        if (!publish(chunk)) {
+            break;
+        }
+    }
+    gzclose(input);
+    finish(error);
+}
+
+void DecompressingLineReader::decompressXz() {
+    FILE * input = fopen(filename.c_str(), "rb");
+    if (input == 0) {
+        finish("unable to open");
+        return;
+    }
+    lzma_stream stream = LZMA_STREAM_INIT;
+    if (lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED)
+        != LZMA_OK) {
+        fclose(input);
+        finish("unable to start the xz decoder");
+        return;
+    }
+    std::vector<uint8_t> compressed(64*1024);
+    std::vector<char> chunk(chunkBytes);
+    stream.next_out = (uint8_t*)chunk.data();
+    stream.avail_out = chunkBytes;
+    lzma_action action = LZMA_RUN;
+    string error;
+    while (true) {
+        if (stream.avail_in == 0 && action == LZMA_RUN) {
+            stream.next_in = compressed.data();
+            stream.avail_in = fread(compressed.data(), 1,
+                                    compressed.size(), input);
+            if (feof(input) || ferror(input)) {
+                action = LZMA_FINISH;
+            }
+        }
+        lzma_ret result = lzma_code(&stream, action);
+        if (stream.avail_out == 0 || result == LZMA_STREAM_END) {
+            chunk.resize(chunkBytes - stream.avail_out);
+            if (!chunk.empty() && !publish(chunk)) {
+                break;
+            }
+            chunk.resize(chunkBytes);
+            stream.next_out = (uint8_t*)chunk.data();
+            stream.avail_out = chunkBytes;
+        }
+        if (result == LZMA_STREAM_END) {
+            break;
+        }
+        if (result != LZMA_OK) {
+            error = (result == LZMA_BUF_ERROR) ? "truncated xz data"
+                : "corrupt xz data";
+            break;
+        }
+    }
+    lzma_end(&stream);
+    fclose(input);
+    finish(error);
+}
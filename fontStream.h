@@ -0,0 +1,135 @@
+// fontStream.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Line readers for the font loaders, over plain files or, with
+//  decompression running on a thread of its own, .gz and .xz files
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    fontStream.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef FONTSTREAM_H
+#define FONTSTREAM_H
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// true for .gz and .xz files, which need a DecompressingLineReader
+bool compressedFontFile(const string & filename);
+
+// the name without any .gz or .xz, for picking a parser by extension
+string uncompressedFontName(const string & filename);
+
+class PlainLineReader {
+public:
+
+    PlainLineReader(string filename) : input(filename.c_str()) {
+    }
+
+    bool getline(string & line) {
+        return (bool)std::getline(input, line);
+    }
+
+    string error() const {
+        return "";
+    }
+
+private:
+
+    std::ifstream input;
+};
+
+// The decompressor runs on its own thread, filling chunks of text
+// which are handed over through a queue of at most queueDepth
+// chunks, so decompression of the next chunks overlaps the parsing
+// of this one without the whole font ever being held in memory.
+// Chunks are recycled rather than reallocated. getline() splits
+// lines as std::getline() would.
+class DecompressingLineReader {
+public:
+
+    DecompressingLineReader(string filename,
+                            size_t chunkBytes = 256*1024,
+                            int queueDepth = 4);
+    ~DecompressingLineReader();
+
+    bool getline(string & line);
+
+    // empty unless the file could not be opened or decompressed
+    string error() const;
+
+private:
+
+    void decompressGzip();
+    void decompressXz();
+
+    // called by the decompressor; false once the reader has gone
+    bool publish(std::vector<char> & chunk);
+    void finish(string failure);
+
+    // called by the parser; false at the end of the file
+    bool nextChunk();
+
+    string filename;
+    size_t chunkBytes;
+    size_t queueDepth;
+
+    mutable std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<char> > ready;
+    std::vector<std::vector<char> > spare;
+    bool finished;
+    bool stopping;
+    string failure;
+
+    std::vector<char> current;
+    size_t position;
+    std::thread worker;
+
+    DecompressingLineReader(const DecompressingLineReader &);
+    DecompressingLineReader & operator=(const DecompressingLineReader &);
+};
+
+// runs parse(reader) with whichever reader suits the file, and
+// reports any decompression error once parsing is done
+template<class Parse>
+auto parseFontLines(const string & filename, Parse parse)
+    -> decltype(parse(std::declval<PlainLineReader &>())) {
+    if (!compressedFontFile(filename)) {
+        PlainLineReader input(filename);
+        return parse(input);
+    }
+    DecompressingLineReader input(filename);
+    auto result = parse(input);
+    if (!input.error().empty()) {
+        std::cerr << "Unable to read " << filename << ": "
+                  << input.error() << std::endl;
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,354 @@
+// fontSubset.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Trims a font down to just the glyphs a corpus of text uses, as
+//  BDF, unifont .hex or a compact binary snapshot, so that fixed
+//  repertoire deployments need not load all of unifont
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    fontSubset.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "fontSubset.h"
+#include <set>
+#include <algorithm>
+#include <cstdio>
+#include <cctype>
+
+// one glyph as pulled from the source font, with the original lines
+// kept if it came from a BDF so they can be passed through untouched
+struct SubsetGlyph {
+    int codepoint;
+    int width;
+    int height;
+    int xOffset;
+    int yOffset;
+    int dWidth;
+    std::vector<string> hexRows;
+    std::vector<string> bdfLines;
+};
+
+// how much of text can be tokenized now, leaving any UTF-8 sequence
+// or U+ escape which the next chunk might still complete
+static size_t completeTextLength(const string & text) {
+    size_t end = text.size();
+    for (size_t back = 1; back <= 3 && back <= end; back++) {
+        unsigned char c = text[end - back];
+        if ((c & 0xC0) != 0x80) {
+            size_t length = 1;
+            if ((c & 0xE0) == 0xC0) {
+                length = 2;
+            } else if ((c & 0xF0) == 0xE0) {
+                length = 3;
+            } else if ((c & 0xF8) == 0xF0) {
+                length = 4;
+            }
+            if (length > back) {
+                end -= back;
+            }
+            break;
+        }
+    }
+    size_t digits = 0;
+    while (digits < 6 && digits < end
+           && isxdigit((unsigned char)text[end - 1 - digits])) {
+        digits++;
+    }
+    if (digits < 6) {
+        size_t at = end - digits;
+        if (at >= 2 && text[at - 2] == 'U' && text[at - 1] == '+') {
+            end = at - 2;
+        } else if (digits == 0 && at >= 1 && text[at - 1] == 'U') {
+            end = at - 1;
+        }
+    }
+    return end;
+}
+
+// read a chunk at a time, so a large corpus is never held whole
+std::set<int> corpusCodepoints(string corpusFile) {
+    std::set<int> codepoints;
+    std::ifstream input(corpusFile.c_str(), std::ios::binary);
+    if (!input) {
+        std::cout << "Unable to open corpus: " << corpusFile << std::endl;
+        return codepoints;
+    }
+    const size_t chunkSize = 1 << 16;
+    std::vector<char> chunk(chunkSize);
+    string text;
+    bool finished = false;
+    while (!finished) {
+        input.read(chunk.data(), chunkSize);
+        text.append(chunk.data(), input.gcount());
+        finished = !input;
+        size_t complete = finished ? text.size() : completeTextLength(text);
+        Utf8Tokenizer tokens(std::string_view(text).substr(0, complete));
+        int codepoint;
+        while (tokens.next(codepoint)) {
+            codepoints.insert(codepoint);
+        }
+        text.erase(0, complete);
+    }
+    return codepoints;
+}
+
+// the glyphs in wanted, from a BDF or .hex font's lines
+template<class LineReader>
+static void extractGlyphLines(LineReader & input,
+                              bool hexFont,
+                              const std::set<int> & wanted,
+                              std::vector<string> & header,
+                              std::vector<SubsetGlyph> & glyphs) {
+    std::string latestLine;
+    bool inHeader = !hexFont;
+    SubsetGlyph glyph;
+    bool inGlyph = false;
+    bool inBitmap = false;
+    while (input.getline(latestLine)) {
+        if (hexFont) {
+            size_t colon = latestLine.find(':');
+            if (colon == string::npos) {
+                continue;
+            }
+            glyph.codepoint = std::strtol(latestLine.c_str(), 0, 16);
+            if (!wanted.count(glyph.codepoint)) {
+                continue;
+            }
+            string bitmap = latestLine.substr(colon + 1);
+            while (!bitmap.empty()
+                   && isspace((unsigned char)bitmap.back())) {
+                bitmap.erase(bitmap.length() - 1);
+            }
+            int rowDigits = bitmap.length()/16;
+            if (rowDigits == 0 || bitmap.length() % 16) {
+                continue;
+            }
+            glyph.width = glyph.dWidth = rowDigits*4;
+            glyph.height = 16;
+            glyph.xOffset = 0;
+            glyph.yOffset = -2;
+            glyph.hexRows.clear();
+            for (int row = 0; row < 16; row++) {
+                glyph.hexRows.push_back(bitmap.substr(row*rowDigits,
+                                                      rowDigits));
+            }
+            glyphs.push_back(glyph);
+        } else if (!strncmp(latestLine.c_str(), "STARTCHAR", 9)) {
+            inHeader = false;
+            inGlyph = true;
+            inBitmap = false;
+            glyph.codepoint = -1;
+            glyph.width = glyph.height = glyph.dWidth = 0;
+            glyph.xOffset = glyph.yOffset = 0;
+            glyph.hexRows.clear();
+            glyph.bdfLines.assign(1, latestLine);
+        } else if (inHeader) {
+            if (strncmp(latestLine.c_str(), "CHARS ", 6)) {
+                header.push_back(latestLine);
+            }
+        } else if (inGlyph) {
+            glyph.bdfLines.push_back(latestLine);
+            if (!strncmp(latestLine.c_str(), "ENDCHAR", 7)) {
+                if (wanted.count(glyph.codepoint)) {
+                    glyphs.push_back(glyph);
+                }
+                inGlyph = false;
+            } else if (inBitmap) {
+                glyph.hexRows.push_back(latestLine);
+            } else if (!strncmp(latestLine.c_str(), "ENCODING ", 9)) {
+                glyph.codepoint = std::atoi(latestLine.c_str() + 9);
+            } else if (!strncmp(latestLine.c_str(), "BBX ", 4)) {
+                sscanf(latestLine.c_str() + 4, "%d %d %d %d",
+                       &glyph.width, &glyph.height,
+                       &glyph.xOffset, &glyph.yOffset);
+            } else if (!strncmp(latestLine.c_str(), "DWIDTH ", 7)) {
+                glyph.dWidth = std::atoi(latestLine.c_str() + 7);
+            } else if (!strncmp(latestLine.c_str(), "BITMAP", 6)) {
+                inBitmap = true;
+            }
+        }
+    }
+}
+
+// one pass over a BDF or .hex font, compressed or not, keeping the
+// glyphs in wanted; header gets the BDF header lines, less CHARS
+static void extractGlyphs(string fontFile,
+                          const std::set<int> & wanted,
+                          std::vector<string> & header,
+                          std::vector<SubsetGlyph> & glyphs) {
+    StageTimer timer(renderStats.loadSeconds);
+    bool hexFont = hasExtension(uncompressedFontName(fontFile), ".hex");
+    parseFontLines(fontFile, [&](auto & input) {
+            extractGlyphLines(input, hexFont, wanted, header, glyphs);
+            return 0;
+        });
+}
+
+static void appendLine(string & output, const string & line) {
+    output += line;
+    output += '\n';
+}
+
+static string subsetAsBDF(std::vector<string> & header,
+                          std::vector<SubsetGlyph> & glyphs) {
+    string output;
+    if (header.empty()) { // from a .hex font, so unifont's metrics
+        header.push_back("STARTFONT 2.1");
+        header.push_back("FONT -gnu-Unifont-Medium-R-Normal-Sans-16-160-75-75-c-80-iso10646-1");
+        header.push_back("SIZE 16 75 75");
+        header.push_back("FONTBOUNDINGBOX 16 16 0 -2");
+        header.push_back("STARTPROPERTIES 2");
+        header.push_back("FONT_ASCENT 14");
+        header.push_back("FONT_DESCENT 2");
+        header.push_back("ENDPROPERTIES");
+    }
+    for (int line = 0; line < header.size(); line++) {
+        appendLine(output, header[line]);
+    }
+    appendLine(output, "CHARS " + std::to_string(glyphs.size()));
+    char line[64];
+    for (int index = 0; index < glyphs.size(); index++) {
+        SubsetGlyph & glyph = glyphs[index];
+        if (!glyph.bdfLines.empty()) {
+            for (int bdfLine = 0; bdfLine < glyph.bdfLines.size(); bdfLine++) {
+                appendLine(output, glyph.bdfLines[bdfLine]);
+            }
+            continue;
+        }
+        snprintf(line, sizeof(line), "STARTCHAR U+%04X", glyph.codepoint);
+        appendLine(output, line);
+        snprintf(line, sizeof(line), "ENCODING %d", glyph.codepoint);
+        appendLine(output, line);
+        snprintf(line, sizeof(line), "SWIDTH %d 0", glyph.dWidth*1000/16);
+        appendLine(output, line);
+        snprintf(line, sizeof(line), "DWIDTH %d 0", glyph.dWidth);
+        appendLine(output, line);
+        snprintf(line, sizeof(line), "BBX %d %d %d %d", glyph.width,
+                 glyph.height, glyph.xOffset, glyph.yOffset);
+        appendLine(output, line);
+        appendLine(output, "BITMAP");
+        for (int row = 0; row < glyph.hexRows.size(); row++) {
+            appendLine(output, glyph.hexRows[row]);
+        }
+        appendLine(output, "ENDCHAR");
+    }
+    appendLine(output, "ENDFONT");
+    return output;
+}
+
+// .hex can only hold unifont shaped glyphs, 16 rows of 8 or 16
+static string subsetAsHex(std::vector<SubsetGlyph> & glyphs) {
+    string output;
+    char codepoint[16];
+    for (int index = 0; index < glyphs.size(); index++) {
+        SubsetGlyph & glyph = glyphs[index];
+        if (glyph.hexRows.size() != 16
+            || (glyph.width != 8 && glyph.width != 16)) {
+            std::cout << "Glyph " << glyph.codepoint
+                      << " cannot be represented in .hex, skipped."
+                      << std::endl;
+            continue;
+        }
+        snprintf(codepoint, sizeof(codepoint), "%04X:", glyph.codepoint);
+        output += codepoint;
+        for (int row = 0; row < 16; row++) {
+            output += glyph.hexRows[row];
+        }
+        output += '\n';
+    }
+    return output;
+}
+
+static string subsetAsSnapshot(std::vector<SubsetGlyph> & glyphs) {
+    string output;
+    FontSnapshotHeader header;
+    memcpy(header.magic, fontSnapshotMagic, 8);
+    header.glyphCount = glyphs.size();
+    output.append((const char*)&header, sizeof(header));
+    for (int index = 0; index < glyphs.size(); index++) {
+        SubsetGlyph & glyph = glyphs[index];
+        FontSnapshotRecord record;
+        memset(&record, 0, sizeof(record));
+        record.codepoint = glyph.codepoint;
+        record.width = glyph.width;
+        record.height = glyph.hexRows.size();
+        record.xOffset = glyph.xOffset;
+        record.yOffset = glyph.yOffset;
+        record.dWidth = glyph.dWidth;
+        record.rowBytes = glyph.hexRows.empty()
+            ? 0 : glyph.hexRows[0].length()/2;
+        output.append((const char*)&record, sizeof(record));
+        for (int row = 0; row < record.height; row++) {
+            for (int byte = 0; byte < record.rowBytes; byte++) {
+                char digits[3] = {0, 0, 0};
+                if (2*byte + 1 < glyph.hexRows[row].length()) {
+                    digits[0] = glyph.hexRows[row][2*byte];
+                    digits[1] = glyph.hexRows[row][2*byte + 1];
+                }
+                output += (char)std::strtol(digits, 0, 16);
+            }
+        }
+    }
+    return output;
+}
+
+int writeFontSubset(string corpusFile,
+                    std::vector<string> fontFiles,
+                    string subsetFile) {
+    std::set<int> wanted = corpusCodepoints(corpusFile);
+    size_t wantedCount = wanted.size();
+    std::vector<string> header;
+    std::vector<SubsetGlyph> glyphs;
+    for (int font = 0; font < fontFiles.size() && !wanted.empty(); font++) {
+        size_t found = glyphs.size();
+        std::vector<string> fontHeader;
+        extractGlyphs(fontFiles[font], wanted, fontHeader, glyphs);
+        if (header.empty()) {
+            header = fontHeader;
+        }
+        for (; found < glyphs.size(); found++) {
+            wanted.erase(glyphs[found].codepoint);
+        }
+    }
+    std::sort(glyphs.begin(), glyphs.end(),
+              [](const SubsetGlyph & a, const SubsetGlyph & b) {
+                  return a.codepoint < b.codepoint;
+              });
+    string output;
+    if (hasExtension(subsetFile, ".hex")) {
+        output = subsetAsHex(glyphs);
+    } else if (hasExtension(subsetFile, ".u2f")) {
+        output = subsetAsSnapshot(glyphs);
+    } else {
+        output = subsetAsBDF(header, glyphs);
+    }
+    FILE * fOutput = fopen(subsetFile.c_str(), "wb");
+    if (fOutput == 0) {
+        std::cout << "Unable to open output file: " << subsetFile << std::endl;
+        return 1;
+    }
+    bool failed = fwrite(output.data(), 1, output.size(), fOutput)
+        != output.size();
+    failed = (fclose(fOutput) != 0) || failed;
+    renderStats.bytesWritten += output.size();
+    std::cout << glyphs.size() << " of " << wantedCount
+              << " codepoints in the corpus found, written to "
+              << subsetFile << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,44 @@
+// fontSubset.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Trims a font down to just the glyphs a corpus of text uses, as
+//  BDF, unifont .hex or a compact binary snapshot, so that fixed
+//  repertoire deployments need not load all of unifont
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    fontSubset.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef FONTSUBSET_H
+#define FONTSUBSET_H
+
+#include "bitmap2waterfall.h"
+#include <set>
+
+// the set of codepoints used by a corpus, tokenized as a message is
+std::set<int> corpusCodepoints(string corpusFile);
+
+// writes the glyphs used in corpusFile to subsetFile, as .hex or a
+// .u2f snapshot by extension, or otherwise as BDF; each codepoint is
+// taken from the first of fontFiles that has it, as FontChain would
+int writeFontSubset(string corpusFile,
+                    std::vector<string> fontFiles,
+                    string subsetFile);
+
+#endif
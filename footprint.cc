@@ -0,0 +1,214 @@
+// footprint.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Turns glyph bitmaps into gEDA PCB footprints, either silkscreen
+//  ElementLines or square copper Pads, merging lit pixels into as
+//  few rectangles as possible to keep element counts down
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    footprint.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "footprint.h"
+#include <atomic>
+#include <thread>
+#include <cstdio>
+
+// Greedy decomposition into rectangles: working down the glyph,
+// each run of lit pixels not yet covered is taken as wide as it
+// goes, then extended down for as long as the rows below have the
+// same run lit and uncovered.
+std::vector<PixelRect> mergePixelRectangles(const PackedBitmap & bitmap) {
+    std::vector<PixelRect> rects;
+    std::vector<uint64_t> used(bitmap.height, 0);
+    for (int y = 0; y < bitmap.height; y++) {
+        uint64_t available = bitmap.rows[y] & ~used[y];
+        while (available != 0) {
+            int x0 = __builtin_ctzll(available);
+            uint64_t fromX0 = available >> x0;
+            int runLength = (~fromX0 == 0) ? 64 - x0
+                : __builtin_ctzll(~fromX0);
+            uint64_t runMask = (runLength == 64) ? ~(uint64_t)0
+                : (((uint64_t)1 << runLength) - 1) << x0;
+            int y1 = y;
+            while (y1 + 1 < bitmap.height
+                   && (bitmap.rows[y1 + 1] & ~used[y1 + 1] & runMask)
+                   == runMask) {
+                y1++;
+                used[y1] |= runMask;
+            }
+            used[y] |= runMask;
+            available &= ~runMask;
+            PixelRect rect;
+            rect.x0 = x0;
+            rect.y0 = y;
+            rect.x1 = x0 + runLength - 1;
+            rect.y1 = y1;
+            rects.push_back(rect);
+        }
+    }
+    return rects;
+}
+
+// each rectangle becomes one line, or pad, as thick as the
+// rectangle's short side and running down the middle of its long
+// side, so that the line's end caps reach the rectangle's edges
+static void appendRectPrimitives(std::vector<PixelRect> & rects,
+                                 int xOffset,
+                                 const FootprintOptions & options,
+                                 string & footprint) {
+    char line[160];
+    int pitch = options.pixelPitch;
+    for (int index = 0; index < rects.size(); index++) {
+        PixelRect & rect = rects[index];
+        int width = rect.x1 - rect.x0 + 1;
+        int height = rect.y1 - rect.y0 + 1;
+        int thickness = ((width < height) ? width : height)*pitch;
+        // doubled coordinates keep the centres on whole centimils
+        long x1, y1, x2, y2;
+        if (width >= height) {
+            x1 = (2*(xOffset + rect.x0) + height)*pitch/2;
+            x2 = (2*(xOffset + rect.x1 + 1) - height)*pitch/2;
+            y1 = y2 = (rect.y0 + rect.y1 + 1)*pitch/2;
+        } else {
+            y1 = (2*rect.y0 + width)*pitch/2;
+            y2 = (2*(rect.y1 + 1) - width)*pitch/2;
+            x1 = x2 = (2*xOffset + rect.x0 + rect.x1 + 1)*pitch/2;
+        }
+        if (options.pads) {
+            snprintf(line, sizeof(line),
+                     "\tPad[%ld %ld %ld %ld %d %d %d \"\" \"1\" \"square\"]\n",
+                     x1, y1, x2, y2, thickness, 2000, thickness + 600);
+        } else {
+            snprintf(line, sizeof(line),
+                     "\tElementLine [%ld %ld %ld %ld %d]\n",
+                     x1, y1, x2, y2, thickness);
+        }
+        footprint += line;
+    }
+}
+
+static string footprintHeader(string description) {
+    for (int index = 0; index < description.length(); index++) {
+        if (description[index] == '"') {
+            description[index] = '\'';
+        }
+    }
+    return "Element[\"\" \"" + description + "\" \"\" \"\" 0 0 0 -2000 0 100 \"\"]\n(\n";
+}
+
+static string codepointName(int codepoint) {
+    char name[16];
+    snprintf(name, sizeof(name), "U+%04X", codepoint);
+    return name;
+}
+
+string glyphFootprint(Glyph & glyph,
+                      int codepoint,
+                      const FootprintOptions & options) {
+    std::vector<PixelRect> rects = mergePixelRectangles(glyph.packedBitmap());
+    string footprint = footprintHeader(codepointName(codepoint));
+    appendRectPrimitives(rects, 0, options, footprint);
+    footprint += ")\n";
+    return footprint;
+}
+
+string textFootprint(map<int, Glyph*> & glyphMap,
+                     std::string_view text,
+                     const FootprintOptions & options) {
+    string footprint = footprintHeader(string(text));
+    Utf8Tokenizer tokens(text);
+    int codepoint;
+    int x = 0;
+    while (tokens.next(codepoint)) {
+        map<int, Glyph*>::iterator found = glyphMap.find(codepoint);
+        if (found == glyphMap.end() || found->second == 0) {
+            std::cerr << "Glyph "<< codepoint
+                      << " not found in bdf file." << std::endl;
+            renderStats.missingGlyphs++;
+            continue;
+        }
+        const PackedBitmap & bitmap = found->second->packedBitmap();
+        std::vector<PixelRect> rects = mergePixelRectangles(bitmap);
+        appendRectPrimitives(rects, x, options, footprint);
+        renderStats.glyphsRendered++;
+        x += bitmap.width;
+    }
+    footprint += ")\n";
+    return footprint;
+}
+
+static bool writeFootprintFile(const string & footprint, string fName) {
+    FILE * fOutput = fopen(fName.c_str(), "wb");
+    if (fOutput == 0) {
+        return false;
+    }
+    bool failed = fwrite(footprint.data(), 1, footprint.size(), fOutput)
+        != footprint.size();
+    failed = (fclose(fOutput) != 0) || failed;
+    return !failed;
+}
+
+// each thread takes every nth glyph
+int writeFootprintLibrary(map<int, Glyph*> & glyphMap,
+                          int first,
+                          int last,
+                          string directory,
+                          const FootprintOptions & options) {
+    std::vector<std::pair<int, Glyph*> > glyphs;
+    map<int, Glyph*>::iterator iter = glyphMap.lower_bound(first);
+    for (; iter != glyphMap.end() && iter->first <= last; iter++) {
+        if (iter->second != 0) {
+            glyphs.push_back(*iter);
+        }
+    }
+    std::atomic<int> failures(0);
+    int threadCount = std::thread::hardware_concurrency();
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers.push_back(std::thread([&, thread]() {
+            for (size_t glyph = thread; glyph < glyphs.size();
+                 glyph += threadCount) {
+                string footprint = glyphFootprint(*glyphs[glyph].second,
+                                                  glyphs[glyph].first,
+                                                  options);
+                if (!writeFootprintFile(footprint, directory + "/"
+                                        + codepointName(glyphs[glyph].first)
+                                        + ".fp")) {
+                    failures++;
+                }
+            }
+        }));
+    }
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers[thread].join();
+    }
+    renderStats.glyphsRendered += glyphs.size() - failures;
+    std::cout << glyphs.size() - failures << " footprints written to "
+              << directory << std::endl;
+    if (failures != 0) {
+        std::cout << failures << " footprints could not be written."
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// footprint.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Turns glyph bitmaps into gEDA PCB footprints, either silkscreen
+//  ElementLines or square copper Pads, merging lit pixels into as
+//  few rectangles as possible to keep element counts down
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    footprint.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef FOOTPRINT_H
+#define FOOTPRINT_H
+
+#include "bitmap2waterfall.h"
+
+struct FootprintOptions {
+    int pixelPitch; // centimils, i.e. 1000 = 10 mil pixels
+    bool pads;      // copper pads rather than silkscreen lines
+};
+
+// lit pixels from (x0, y0) to (x1, y1) inclusive
+struct PixelRect {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+// the lit pixels as rectangles which cover each of them exactly once
+std::vector<PixelRect> mergePixelRectangles(const PackedBitmap & bitmap);
+
+string glyphFootprint(Glyph & glyph,
+                      int codepoint,
+                      const FootprintOptions & options);
+
+// a whole string of glyphs, side by side, as a single element
+string textFootprint(map<int, Glyph*> & glyphMap,
+                     std::string_view text,
+                     const FootprintOptions & options);
+
+// one U+XXXX.fp file per glyph in [first, last] found in the font,
+// written into directory, using all cores
+int writeFootprintLibrary(map<int, Glyph*> & glyphMap,
+                          int first,
+                          int last,
+                          string directory,
+                          const FootprintOptions & options);
+
+#endif
@@ -0,0 +1,143 @@
+// glyphChart.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  A chart of every glyph in a Unicode plane, as one image or ASCII
+//  sheet, in the manner of unifoundry's unifont charts
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    glyphChart.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "glyphChart.h"
+#include "waterfallImage.h"
+#include "banner.h"
+#include <thread>
+
+static const int chartTiles = 256; // tiles along each side
+static const uint8_t chartLit = 0;
+static const uint8_t chartUnlit = 255;
+static const uint8_t chartMissing = 208;
+
+// runs work(tileRow) for every row of tiles, rows being dealt out
+// to the threads in turn
+template<class Work>
+static void forEachTileRow(int threadCount, Work work) {
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers.push_back(std::thread([&, thread]() {
+            for (int tileRow = thread; tileRow < chartTiles;
+                 tileRow += threadCount) {
+                work(tileRow);
+            }
+        }));
+    }
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers[thread].join();
+    }
+}
+
+int writeGlyphChart(map<int, Glyph*> & glyphMap, int plane, string fName) {
+    if (plane < 0 || plane > 16) {
+        std::cout << "No such Unicode plane: " << plane << std::endl;
+        return 1;
+    }
+    std::vector<Glyph*> tiles(chartTiles*chartTiles, (Glyph*)0);
+    int first = plane << 16;
+    map<int, Glyph*>::iterator iter = glyphMap.lower_bound(first);
+    for (; iter != glyphMap.end() && iter->first < first + (int)tiles.size();
+         iter++) {
+        tiles[iter->first - first] = iter->second;
+    }
+    int threadCount = std::thread::hardware_concurrency();
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    // glyphs are parsed and packed on first use, so the tile size is
+    // found on all cores too, each thread keeping its own maximum
+    std::vector<int> widths(chartTiles, 0);
+    std::vector<int> heights(chartTiles, 0);
+    forEachTileRow(threadCount, [&](int tileRow) {
+            for (int tile = tileRow*chartTiles;
+                 tile < (tileRow + 1)*chartTiles; tile++) {
+                if (tiles[tile] != 0) {
+                    const PackedBitmap & bitmap = tiles[tile]->packedBitmap();
+                    widths[tileRow] = std::max(widths[tileRow], bitmap.width);
+                    heights[tileRow] = std::max(heights[tileRow],
+                                                bitmap.height);
+                }
+            }
+        });
+    int tileWidth = *std::max_element(widths.begin(), widths.end());
+    int tileHeight = *std::max_element(heights.begin(), heights.end());
+    if (tileWidth == 0 || tileHeight == 0) {
+        std::cout << "No glyphs in plane " << plane << std::endl;
+        return 1;
+    }
+
+    // each thread paints its rows of tiles straight into the image
+    int width = tileWidth*chartTiles;
+    int height = tileHeight*chartTiles;
+    std::vector<uint8_t> pixels((size_t)width*height);
+    forEachTileRow(threadCount, [&](int tileRow) {
+            for (int column = 0; column < chartTiles; column++) {
+                Glyph * glyph = tiles[tileRow*chartTiles + column];
+                const PackedBitmap * bitmap =
+                    (glyph != 0) ? &glyph->packedBitmap() : 0;
+                for (int y = 0; y < tileHeight; y++) {
+                    uint8_t * pixel = &pixels[((size_t)tileRow*tileHeight + y)
+                                              *width + column*tileWidth];
+                    if (bitmap == 0) {
+                        memset(pixel, chartMissing, tileWidth);
+                        continue;
+                    }
+                    uint64_t row = (y < bitmap->height) ? bitmap->rows[y] : 0;
+                    for (int x = 0; x < tileWidth; x++) {
+                        pixel[x] = ((row >> x) & 1) ? chartLit : chartUnlit;
+                    }
+                }
+            }
+        });
+    size_t glyphCount = tiles.size() - std::count(tiles.begin(), tiles.end(),
+                                                  (Glyph*)0);
+    renderStats.glyphsRendered += glyphCount;
+
+    int result;
+    if (hasExtension(fName, ".txt")) {
+        string sheet;
+        sheet.reserve((size_t)(width + 1)*height);
+        for (int y = 0; y < height; y++) {
+            const uint8_t * pixel = &pixels[(size_t)y*width];
+            for (int x = 0; x < width; x++) {
+                sheet += (pixel[x] == chartLit) ? '#'
+                    : (pixel[x] == chartUnlit) ? '-' : ' ';
+            }
+            sheet += '\n';
+        }
+        result = writeBanner(sheet, fName);
+    } else {
+        result = writeGrayImage(fName, pixels, width, height);
+    }
+    if (result == 0) {
+        std::cout << glyphCount << " glyphs of plane " << plane
+                  << " charted in " << fName << " (" << width << "x"
+                  << height << ")" << std::endl;
+    }
+    return result;
+}
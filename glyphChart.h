@@ -0,0 +1,40 @@
+// glyphChart.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  A chart of every glyph in a Unicode plane, as one image or ASCII
+//  sheet, in the manner of unifoundry's unifont charts
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    glyphChart.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef GLYPHCHART_H
+#define GLYPHCHART_H
+
+#include "bitmap2waterfall.h"
+
+// The plane's 65536 codepoints as a 256 x 256 grid of tiles, U+xx00
+// to U+xxFF along each row of tiles, each tile being as big as the
+// largest glyph in the plane, i.e. 16 x 18 pixels for unifont. The
+// chart is a PGM, or PNG if fName ends in .png, with lit pixels
+// black, unlit pixels white and codepoints without a glyph grey, or
+// an ASCII sheet of "#", "-" and " " if fName ends in .txt.
+int writeGlyphChart(map<int, Glyph*> & glyphMap, int plane, string fName);
+
+#endif
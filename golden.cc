@@ -0,0 +1,288 @@
+// golden.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Golden output and performance budget checks over a corpus of
+//  messages, so that changes to the renderer cannot silently alter
+//  the audio or slow it down
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    golden.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+// A corpus exercising the renderer, i.e. ASCII punctuation as in the
+// README example, U+262F style escapes, CJK and blank glyphs, might
+// read:
+//
+//    !"#$%&'()*+,-./:;<=>?@[\]^_`{|}~
+//    abcd Test Strings Here U+30U+262FU+002603U+2622U+2623
+//    ☯ 漢字 U+262F
+//    CQ    CQ    de    VK5
+//
+// Each message is written out as main would write it, to a scratch
+// file beside the golden file, and the file is hashed. It is written
+// three ways, by writeGlyphsToAudio() with and without the glyph
+// audio cache and from an atlas of the corpus's glyphs, and all
+// three must agree, so the write stage is timed on real writes.
+
+#include "golden.h"
+#include "audioAtlas.h"
+#include <cstdio>
+#include <unistd.h>
+
+static const uint64_t fnvOffset = 14695981039346656037ULL;
+static const uint64_t fnvPrime = 1099511628211ULL;
+
+bool parseRenderBudget(const string & spec, RenderBudget & budget) {
+    std::istringstream items(spec);
+    string item;
+    while (getline(items, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == string::npos) {
+            return false;
+        }
+        string key = item.substr(0, equals);
+        double limit = std::atof(item.c_str() + equals + 1);
+        if (key == "load") {
+            budget.loadMS = limit;
+        } else if (key == "tokenize") {
+            budget.tokenizeMS = limit;
+        } else if (key == "synthesis") {
+            budget.synthesisMS = limit;
+        } else if (key == "write") {
+            budget.writeMS = limit;
+        } else if (key == "rss") {
+            budget.peakRssKB = (long)limit;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the FNV-1a hash and length of a file's contents
+static bool hashAudioFile(const string & fName,
+                          uint64_t & hash,
+                          unsigned long long & samples) {
+    hash = fnvOffset;
+    samples = 0;
+    FILE * input = fopen(fName.c_str(), "rb");
+    if (input == 0) {
+        return false;
+    }
+    std::vector<uint8_t> buffer(1 << 16);
+    size_t got;
+    while ((got = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+        for (size_t index = 0; index < got; index++) {
+            hash ^= buffer[index];
+            hash *= fnvPrime;
+        }
+        samples += got;
+    }
+    bool failed = ferror(input);
+    fclose(input);
+    return !failed;
+}
+
+// the message's audio as written to scratchFile; false if the
+// writers disagree, or the file can't be read back
+static bool hashMessageAudio(map<int, Glyph*> & glyphMap,
+                             const AudioAtlas & atlas,
+                             const string & message,
+                             GlyphAudioCache & cache,
+                             RenderContext & context,
+                             const string & scratchFile,
+                             uint64_t & hash,
+                             unsigned long long & samples) {
+    writeGlyphsToAudio(glyphMap, message, 0, scratchFile, 0,
+                       &cache, &context);
+    if (!hashAudioFile(scratchFile, hash, samples)) {
+        std::cout << "Unable to read back " << scratchFile << std::endl;
+        return false;
+    }
+    uint64_t uncachedHash, atlasHash;
+    unsigned long long uncachedSamples, atlasSamples;
+    writeGlyphsToAudio(glyphMap, message, 0, scratchFile, 0, 0, &context);
+    bool agree = hashAudioFile(scratchFile, uncachedHash, uncachedSamples)
+        && uncachedHash == hash && uncachedSamples == samples;
+    writeAtlasGlyphsToAudio(atlas, message, 0, scratchFile);
+    agree = hashAudioFile(scratchFile, atlasHash, atlasSamples)
+        && atlasHash == hash && atlasSamples == samples && agree;
+    if (!agree) {
+        char hashes[128];
+        snprintf(hashes, sizeof(hashes),
+                 "cached %016llx, uncached %016llx, atlas %016llx",
+                 (unsigned long long)hash,
+                 (unsigned long long)uncachedHash,
+                 (unsigned long long)atlasHash);
+        std::cout << "Writers disagree for: " << message
+                  << "\n    " << hashes << std::endl;
+    }
+    return agree;
+}
+
+static bool overBudget(const char * stage, double used, double limit) {
+    if (limit < 0 || used <= limit) {
+        return false;
+    }
+    std::cout << "Over budget: " << stage << " took " << used
+              << " ms, budget " << limit << " ms" << std::endl;
+    return true;
+}
+
+int checkGoldenCorpus(FontChain & fonts,
+                      string corpusFile,
+                      string goldenFile,
+                      bool update,
+                      const RenderBudget & budget) {
+    renderStats.enabled = true; // the budget needs the stage times
+    std::ifstream corpus(corpusFile.c_str(), std::ios::binary);
+    if (!corpus) {
+        std::cout << "Unable to open corpus: " << corpusFile << std::endl;
+        return 1;
+    }
+    std::vector<string> messages;
+    string line;
+    while (getline(corpus, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.erase(line.length() - 1);
+        }
+        if (!line.empty()) {
+            messages.push_back(line);
+        }
+    }
+
+    std::map<string, std::pair<uint64_t, unsigned long long> > golden;
+    std::ifstream goldenInput(goldenFile.c_str(), std::ios::binary);
+    while (!update && getline(goldenInput, line)) {
+        // the message follows a single space, and may itself start
+        // with spaces
+        unsigned long long hash, samples;
+        int consumed = 0;
+        if (sscanf(line.c_str(), "%llx %llu%n", &hash, &samples,
+                   &consumed) == 2 && line[consumed] == ' ') {
+            golden[line.substr(consumed + 1)] =
+                std::make_pair((uint64_t)hash, samples);
+        }
+    }
+    if (!update && golden.empty()) {
+        std::cout << "No golden hashes in " << goldenFile
+                  << ", use --update-golden to make them." << std::endl;
+        return 1;
+    }
+
+    // an atlas of just the glyphs the corpus uses
+    map<int, Glyph*> corpusGlyphs;
+    for (size_t index = 0; index < messages.size(); index++) {
+        map<int, Glyph*> & glyphMap = fonts.glyphsFor(messages[index]);
+        Utf8Tokenizer tokens(messages[index]);
+        int codepoint;
+        while (tokens.next(codepoint)) {
+            map<int, Glyph*>::iterator found = glyphMap.find(codepoint);
+            if (found != glyphMap.end()) {
+                corpusGlyphs.insert(*found);
+            }
+        }
+    }
+    string scratchFile = goldenFile + ".raw";
+    string atlasFile = goldenFile + ".atlas";
+    AudioAtlas atlas;
+    if (buildAudioAtlas(corpusGlyphs, atlasFile) || !atlas.open(atlasFile)) {
+        unlink(atlasFile.c_str());
+        return 1;
+    }
+
+    GlyphAudioCache cache;
+    RenderContext context;
+    string updated;
+    int failures = 0;
+    for (size_t index = 0; index < messages.size(); index++) {
+        uint64_t hash;
+        unsigned long long samples;
+        if (!hashMessageAudio(fonts.glyphsFor(messages[index]), atlas,
+                              messages[index], cache, context, scratchFile,
+                              hash, samples)) {
+            failures++;
+            continue;
+        }
+        char entry[64];
+        snprintf(entry, sizeof(entry), "%016llx %llu",
+                 (unsigned long long)hash, samples);
+        if (update) {
+            updated += string(entry) + " " + messages[index] + "\n";
+            continue;
+        }
+        std::map<string, std::pair<uint64_t, unsigned long long> >
+            ::iterator expected = golden.find(messages[index]);
+        if (expected == golden.end()) {
+            std::cout << "No golden hash for: " << messages[index]
+                      << std::endl;
+            failures++;
+        } else if (expected->second.first != hash
+                   || expected->second.second != samples) {
+            char wanted[64];
+            snprintf(wanted, sizeof(wanted), "%016llx %llu",
+                     (unsigned long long)expected->second.first,
+                     expected->second.second);
+            std::cout << "Audio differs for: " << messages[index]
+                      << "\n    expected " << wanted << ", got " << entry
+                      << std::endl;
+            failures++;
+        }
+    }
+    atlas.close();
+    unlink(atlasFile.c_str());
+    unlink(scratchFile.c_str());
+    if (update && failures != 0) {
+        std::cout << "Golden hashes not written to " << goldenFile
+                  << std::endl;
+        return 1;
+    }
+    if (update) {
+        std::ofstream goldenOutput(goldenFile.c_str(), std::ios::binary);
+        goldenOutput << updated;
+        goldenOutput.close();
+        if (!goldenOutput) {
+            std::cout << "Unable to write " << goldenFile << std::endl;
+            return 1;
+        }
+        std::cout << messages.size() << " golden hashes written to "
+                  << goldenFile << std::endl;
+    }
+
+    bool over = false;
+    over = overBudget("load", renderStats.loadSeconds*1000,
+                      budget.loadMS) || over;
+    over = overBudget("tokenize", renderStats.tokenizeSeconds*1000,
+                      budget.tokenizeMS) || over;
+    over = overBudget("synthesis", renderStats.synthesisSeconds*1000,
+                      budget.synthesisMS) || over;
+    over = overBudget("write", renderStats.writeSeconds*1000,
+                      budget.writeMS) || over;
+    long rss = peakRssKB();
+    if (budget.peakRssKB >= 0 && rss > budget.peakRssKB) {
+        std::cout << "Over budget: peak RSS " << rss << " kB, budget "
+                  << budget.peakRssKB << " kB" << std::endl;
+        over = true;
+    }
+    if (!update) {
+        std::cout << messages.size() - failures << " of " << messages.size()
+                  << " messages match " << goldenFile << std::endl;
+    }
+    return (failures != 0 || over) ? 1 : 0;
+}
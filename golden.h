@@ -0,0 +1,61 @@
+// golden.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Golden output and performance budget checks over a corpus of
+//  messages, so that changes to the renderer cannot silently alter
+//  the audio or slow it down
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    golden.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include "bitmap2waterfall.h"
+#include "fontChain.h"
+
+// limits on the stage times and peak memory of a run, with a
+// negative limit left unchecked
+struct RenderBudget {
+    double loadMS;
+    double tokenizeMS;
+    double synthesisMS;
+    double writeMS;
+    long peakRssKB;
+};
+
+// from "load=300,synthesis=2000,rss=262144" and the like, with stage
+// times in ms and rss in kB; false if spec has an unknown key
+bool parseRenderBudget(const string & spec, RenderBudget & budget);
+
+// Writes each non-empty line of corpusFile as a message, to
+// goldenFile.raw, and checks the FNV-1a hash and length of the file
+// against goldenFile, which holds a "hash samples message" line per
+// message; with update the golden file is rewritten from this run
+// instead. The run's stage times and peak RSS are then held to the
+// budget. Returns 1 if the writers disagree on any message, or it
+// differs, is missing from the golden file, or the budget is exceeded.
+int checkGoldenCorpus(FontChain & fonts,
+                      string corpusFile,
+                      string goldenFile,
+                      bool update,
+                      const RenderBudget & budget);
+
+#endif
@@ -0,0 +1,127 @@
+// hellDecoder.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Decodes Hellschreiber audio back into glyph rows with a bank of
+//  Goertzel filters, one per tone channel, so that rendered audio
+//  can be checked against the glyphs it was made from without
+//  having to look at it in fldigi
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    hellDecoder.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "hellDecoder.h"
+#include <atomic>
+#include <thread>
+#include <cstdio>
+
+// each thread takes every nth glyph, with a decoder of its own
+int verifyGlyphAudio(map<int, Glyph*> & glyphMap, vector<int> codes) {
+    std::vector<std::pair<int, Glyph*> > glyphs;
+    if (codes.empty()) {
+        glyphs.assign(glyphMap.begin(), glyphMap.end());
+    } else {
+        for (int index = 0; index < codes.size(); index++) {
+            map<int, Glyph*>::iterator found = glyphMap.find(codes[index]);
+            if (found != glyphMap.end()) {
+                glyphs.push_back(*found);
+            } else {
+                std::cerr << "Glyph "<< codes[index]
+                          << " not found in bdf file." << std::endl;
+            }
+        }
+    }
+    std::vector<int> mismatched;
+    std::atomic<int> mismatches(0);
+    int threadCount = std::thread::hardware_concurrency();
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    std::vector<std::vector<int> > threadMismatches(threadCount);
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers.push_back(std::thread([&, thread]() {
+            RenderContext context;
+            std::vector<uint64_t> decoded;
+            for (size_t index = thread; index < glyphs.size();
+                 index += threadCount) {
+                Glyph & glyph = *glyphs[index].second;
+                const PackedBitmap & bitmap = glyph.packedBitmap();
+                HellDecoder decoder(glyph, bitmap.width);
+                context.arena.reset();
+                size_t length = glyph.audioLength();
+                int8_t * audio = context.arena.allocate<int8_t>(length);
+                int * scratch =
+                    context.arena.allocate<int>(glyph.samplesPerRow());
+                glyph.renderVertAudio(audio, scratch);
+                std::reverse(audio, audio + length); // as written
+                decoder.decodeGlyph(audio, bitmap.height, decoded);
+                if (decoded != bitmap.rows) {
+                    mismatches++;
+                    threadMismatches[thread].push_back(glyphs[index].first);
+                }
+            }
+        }));
+    }
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers[thread].join();
+        mismatched.insert(mismatched.end(),
+                          threadMismatches[thread].begin(),
+                          threadMismatches[thread].end());
+    }
+    std::sort(mismatched.begin(), mismatched.end());
+    std::cout << "Verified " << glyphs.size() << " glyphs, "
+              << mismatches << " mismatched." << std::endl;
+    for (int index = 0; index < mismatched.size() && index < 20; index++) {
+        char name[16];
+        snprintf(name, sizeof(name), "U+%04X", mismatched[index]);
+        std::cout << "Mismatch: " << name << std::endl;
+    }
+    return (mismatches == 0) ? 0 : 1;
+}
+
+int decodeAudioFile(string fName, int rowsPerGlyph, int channels) {
+    if (rowsPerGlyph <= 0 || channels < 1 || channels > 64) {
+        std::cout << "Unable to decode " << rowsPerGlyph << " rows of "
+                  << channels << " channels." << std::endl;
+        return 1;
+    }
+    std::ifstream input(fName.c_str(), std::ios::binary);
+    if (!input) {
+        std::cout << "Unable to open audio file: " << fName << std::endl;
+        return 1;
+    }
+    Glyph defaults((std::list<std::string>()));
+    HellDecoder decoder(defaults, channels);
+    std::vector<int8_t> audio(decoder.samplesPerRow()*rowsPerGlyph);
+    std::vector<uint64_t> rows;
+    string depiction;
+    while (input.read((char*)audio.data(), audio.size())) {
+        decoder.decodeGlyph(audio.data(), rowsPerGlyph, rows);
+        for (int row = 0; row < rowsPerGlyph; row++) {
+            for (int chan = 0; chan < decoder.channelCount(); chan++) {
+                depiction += ((rows[row] >> chan) & 1) ? '#' : '-';
+            }
+            depiction += '\n';
+        }
+        depiction += '\n';
+    }
+    std::cout << depiction;
+    return 0;
+}
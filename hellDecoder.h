@@ -0,0 +1,115 @@
+// hellDecoder.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Decodes Hellschreiber audio back into glyph rows with a bank of
+//  Goertzel filters, one per tone channel, so that rendered audio
+//  can be checked against the glyphs it was made from without
+//  having to look at it in fldigi
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    hellDecoder.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef HELLDECODER_H
+#define HELLDECODER_H
+
+#include "bitmap2waterfall.h"
+
+// Each row of a glyph is one samplesPerRow() long block of audio,
+// in which channel k is a tone at floorFreq + k*freqSpacing. The
+// Goertzel filter for each channel gives the tone's amplitude over
+// the block, and a pixel is taken as lit if that is more than half
+// the amplitude of a lone full strength tone, which is well clear
+// of both the taper on isolated pixels and leakage from neighbours.
+class HellDecoder {
+public:
+
+    HellDecoder(const Glyph & toneSource, int channelCount = 16) {
+        samples = toneSource.samplesPerRow();
+        channels = (channelCount > 64) ? 64 : channelCount;
+        for (int chan = 0; chan < channels; chan++) {
+            // the same not quite pi that generateAudio() uses
+            double omega = (chan*toneSource.freqSpacing
+                            + toneSource.floorFreq)*2*3.1417
+                / toneSource.bitRate;
+            coefficients.push_back(2*cos(omega));
+        }
+        double fullTone = (toneSource.amplitude/16.0)*samples/2;
+        threshold = 0.25*fullTone*fullTone; // half amplitude, as power
+    }
+
+    int samplesPerRow() const {
+        return samples;
+    }
+
+    // as given, but at most 64
+    int channelCount() const {
+        return channels;
+    }
+
+    uint64_t decodeRow(const int8_t * block) const {
+        uint64_t row = 0;
+        for (int chan = 0; chan < channels; chan++) {
+            double coefficient = coefficients[chan];
+            double s1 = 0;
+            double s2 = 0;
+            for (int sample = 0; sample < samples; sample++) {
+                double s0 = block[sample] + coefficient*s1 - s2;
+                s2 = s1;
+                s1 = s0;
+            }
+            double power = s1*s1 + s2*s2 - coefficient*s1*s2;
+            if (power > threshold) {
+                row |= (uint64_t)1 << chan;
+            }
+        }
+        return row;
+    }
+
+    // audio is as written to the .raw file, i.e. with the glyph's
+    // samples reversed, so the last row comes first; the reversal
+    // within each row makes no difference to the tone amplitudes
+    void decodeGlyph(const int8_t * audio,
+                     int rowCount,
+                     std::vector<uint64_t> & rows) const {
+        rows.resize(rowCount);
+        for (int block = 0; block < rowCount; block++) {
+            rows[rowCount - 1 - block] = decodeRow(audio + block*samples);
+        }
+    }
+
+private:
+
+    int samples;
+    int channels;
+    double threshold;
+    std::vector<double> coefficients;
+};
+
+// renders each glyph as writeGlyphsToAudio() would, decodes it again
+// and compares with the glyph's bitmap, on all cores; all glyphs in
+// the font are checked if codes is empty
+int verifyGlyphAudio(map<int, Glyph*> & glyphMap, vector<int> codes);
+
+// prints the glyphs decoded from a .raw file as "#"/"-" rows, with
+// rowsPerGlyph rows and channels columns each; rowsPerGlyph must be
+// positive and channels 1 to 64
+int decodeAudioFile(string fName, int rowsPerGlyph, int channels);
+
+#endif
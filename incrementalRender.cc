@@ -0,0 +1,325 @@
+// incrementalRender.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Re-renders an edited message by resynthesising only the glyphs
+//  which changed, using a manifest kept beside the audio file
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    incrementalRender.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+// The manifest is plain text, a header line and then a line per
+// glyph, in the order the glyphs appear in the audio:
+//
+//    U2TMANIFEST 2 floorFreq freqSpacing charLineDurationMS bitRate
+//        amplitude tor audioBytes mtimeSeconds mtimeNanoseconds
+//        glyphCount
+//    codepoint bitmapHash offset length phase
+//
+// with the bitmap hash in hex. The audio file's size and modification
+// time are those it had once the manifest's render was done, so a
+// file since rewritten by anything else is rendered afresh rather
+// than patched. A glyph only counts as unchanged if its codepoint,
+// bitmap and length all match, so switching fonts resynthesises just
+// the glyphs that actually look different.
+
+#include "incrementalRender.h"
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char manifestMagic[] = "U2TMANIFEST";
+static const int manifestVersion = 2;
+
+string manifestFileName(string fName) {
+    return fName + ".manifest";
+}
+
+void discardManifest(string fName) {
+    unlink(manifestFileName(fName).c_str());
+}
+
+struct AudioFileStamp {
+    bool exists;
+    unsigned long long bytes;
+    long long seconds;
+    long nanoseconds;
+};
+
+static AudioFileStamp audioFileStamp(string fName) {
+    AudioFileStamp stamp = {false, 0, 0, 0};
+    struct stat status;
+    if (stat(fName.c_str(), &status) == 0) {
+        stamp.exists = true;
+        stamp.bytes = status.st_size;
+        stamp.seconds = status.st_mtim.tv_sec;
+        stamp.nanoseconds = status.st_mtim.tv_nsec;
+    }
+    return stamp;
+}
+
+static string manifestToneParameters(const Glyph & glyph) {
+    char line[128];
+    snprintf(line, sizeof(line), "%d %d %d %d %d %d",
+             glyph.floorFreq, glyph.freqSpacing, glyph.charLineDurationMS,
+             glyph.bitRate, glyph.amplitude, glyph.tor);
+    return line;
+}
+
+// false unless the manifest is intact, for the same tone parameters,
+// and was written for the audio file exactly as it now stands
+static bool readManifest(string fName,
+                         const string & toneParameters,
+                         const AudioFileStamp & stamp,
+                         std::vector<ManifestEntry> & entries) {
+    entries.clear();
+    if (!stamp.exists) {
+        return false;
+    }
+    FILE * input = fopen(manifestFileName(fName).c_str(), "r");
+    if (input == 0) {
+        return false;
+    }
+    char magic[16];
+    int version;
+    int tone[6];
+    unsigned long long audioBytes;
+    long long seconds;
+    long nanoseconds;
+    unsigned long glyphCount;
+    bool usable =
+        fscanf(input, "%15s %d %d %d %d %d %d %d %llu %lld %ld %lu",
+               magic, &version,
+               &tone[0], &tone[1], &tone[2], &tone[3], &tone[4], &tone[5],
+               &audioBytes, &seconds, &nanoseconds, &glyphCount) == 12
+        && !strcmp(magic, manifestMagic)
+        && version == manifestVersion
+        && audioBytes == stamp.bytes
+        && seconds == stamp.seconds
+        && nanoseconds == stamp.nanoseconds;
+    if (usable) {
+        char line[128];
+        snprintf(line, sizeof(line), "%d %d %d %d %d %d",
+                 tone[0], tone[1], tone[2], tone[3], tone[4], tone[5]);
+        usable = (toneParameters == line);
+    }
+    uint64_t expectedOffset = 0;
+    for (unsigned long glyph = 0; usable && glyph < glyphCount; glyph++) {
+        ManifestEntry entry;
+        unsigned long long hash, offset, length;
+        usable = fscanf(input, "%d %llx %llu %llu %d", &entry.codepoint,
+                        &hash, &offset, &length, &entry.phase) == 5
+            && offset == expectedOffset;
+        entry.bitmapHash = hash;
+        entry.offset = offset;
+        entry.length = length;
+        expectedOffset += length;
+        entries.push_back(entry);
+    }
+    fclose(input);
+    if (!usable || expectedOffset != stamp.bytes) {
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+// written to a temporary file first, so a manifest is never half
+// there, and only once the audio file is complete
+static bool writeManifest(string fName,
+                          const string & toneParameters,
+                          const std::vector<ManifestEntry> & entries) {
+    AudioFileStamp stamp = audioFileStamp(fName);
+    if (!stamp.exists) {
+        return false;
+    }
+    string manifest = manifestFileName(fName);
+    string temporary = manifest + ".tmp";
+    FILE * output = fopen(temporary.c_str(), "w");
+    if (output == 0) {
+        return false;
+    }
+    fprintf(output, "%s %d %s %llu %lld %ld %lu\n", manifestMagic,
+            manifestVersion, toneParameters.c_str(), stamp.bytes,
+            stamp.seconds, stamp.nanoseconds, (unsigned long)entries.size());
+    for (size_t index = 0; index < entries.size(); index++) {
+        const ManifestEntry & entry = entries[index];
+        fprintf(output, "%d %016llx %llu %llu %d\n", entry.codepoint,
+                (unsigned long long)entry.bitmapHash,
+                (unsigned long long)entry.offset,
+                (unsigned long long)entry.length, entry.phase);
+    }
+    bool failed = ferror(output);
+    failed = (fclose(output) != 0) || failed;
+    return !failed && rename(temporary.c_str(), manifest.c_str()) == 0;
+}
+
+// copies bytes [start, end) of from to the end of to
+static bool copyFileRange(FILE * from, uint64_t start, uint64_t end,
+                          FILE * to) {
+    std::vector<char> buffer(1 << 20);
+    if (fseeko(from, start, SEEK_SET) != 0) {
+        return false;
+    }
+    while (start < end) {
+        size_t wanted = std::min((uint64_t)buffer.size(), end - start);
+        size_t got = fread(buffer.data(), 1, wanted, from);
+        if (got == 0 || fwrite(buffer.data(), 1, got, to) != got) {
+            return false;
+        }
+        start += got;
+    }
+    return true;
+}
+
+static bool sameGlyph(const ManifestEntry & a, const ManifestEntry & b) {
+    return a.codepoint == b.codepoint && a.bitmapHash == b.bitmapHash
+        && a.length == b.length && a.phase == b.phase;
+}
+
+int writeGlyphsToAudioIncremental(map<int, Glyph*> & glyphMap,
+                                  std::string_view glyphString,
+                                  int extraSpaces,
+                                  string fName,
+                                  GlyphAudioCache * cache,
+                                  RenderContext * context) {
+
+    RenderContext localContext;
+    if (context == 0) {
+        context = &localContext;
+    }
+    Glyph defaults((std::list<std::string>()));
+    string toneParameters = manifestToneParameters(defaults);
+
+    // the new message's manifest, from the font alone
+    vector<int> codes = stringToGlyphCodeVector(glyphString, extraSpaces);
+    std::vector<ManifestEntry> entries(codes.size());
+    uint64_t newBytes = 0;
+    for (size_t index = 0; index < codes.size(); index++) {
+        ManifestEntry & entry = entries[index];
+        map<int, Glyph*>::iterator found = glyphMap.find(codes[index]);
+        bool present = (found != glyphMap.end() && found->second != 0);
+        entry.codepoint = codes[index];
+        entry.bitmapHash = present ? found->second->bitmapHash() : 0;
+        entry.offset = newBytes;
+        entry.length = present ? found->second->audioLength() : 0;
+        entry.phase = 0; // generateAudio() restarts the tone per glyph
+        newBytes += entry.length;
+    }
+
+    std::vector<ManifestEntry> previous;
+    AudioFileStamp stamp = audioFileStamp(fName);
+    uint64_t oldBytes = stamp.bytes;
+    bool usable = readManifest(fName, toneParameters, stamp, previous);
+
+    // the unchanged runs at either end, which must not overlap
+    size_t prefix = 0;
+    size_t suffix = 0;
+    size_t common = std::min(previous.size(), entries.size());
+    while (prefix < common && sameGlyph(previous[prefix], entries[prefix])) {
+        prefix++;
+    }
+    while (suffix < common - prefix
+           && sameGlyph(previous[previous.size() - 1 - suffix],
+                        entries[entries.size() - 1 - suffix])) {
+        suffix++;
+    }
+    uint64_t oldStart = (prefix < previous.size())
+        ? previous[prefix].offset : oldBytes;
+    uint64_t oldEnd = (suffix > 0)
+        ? previous[previous.size() - suffix].offset : oldBytes;
+    uint64_t newStart = (prefix < entries.size())
+        ? entries[prefix].offset : newBytes;
+    uint64_t newEnd = (suffix > 0)
+        ? entries[entries.size() - suffix].offset : newBytes;
+
+    // only the middle is synthesised
+    std::vector<int8_t> middle;
+    middle.reserve(newEnd - newStart);
+    for (size_t index = prefix; index < entries.size() - suffix; index++) {
+        size_t length;
+        const int8_t * audio = renderGlyphCodeAudio(glyphMap, codes[index],
+                                                    cache, *context, length);
+        if (audio == 0) {
+            std::cerr << "Glyph "<< codes[index]
+                      << " not found in bdf file." << std::endl;
+            continue;
+        }
+        middle.insert(middle.end(), audio, audio + length);
+    }
+    if (middle.size() != newEnd - newStart) {
+        std::cout << "Unexpected glyph audio length, not rendering "
+                  << fName << std::endl;
+        return 1;
+    }
+
+    StageTimer timer(renderStats.writeSeconds);
+    // a stale manifest must not outlive a partly rewritten file
+    discardManifest(fName);
+    bool failed;
+    string how;
+    if (usable && newEnd - newStart == oldEnd - oldStart) {
+        FILE * output = fopen(fName.c_str(), "r+b");
+        failed = (output == 0);
+        if (!failed) {
+            failed = fseeko(output, oldStart, SEEK_SET) != 0
+                || fwrite(middle.data(), 1, middle.size(), output)
+                != middle.size();
+            failed = (fclose(output) != 0) || failed;
+        }
+        how = "patched in place";
+    } else if (usable) {
+        string temporary = fName + ".tmp";
+        FILE * input = fopen(fName.c_str(), "rb");
+        FILE * output = fopen(temporary.c_str(), "wb");
+        failed = (input == 0 || output == 0);
+        if (!failed) {
+            failed = !copyFileRange(input, 0, oldStart, output)
+                || fwrite(middle.data(), 1, middle.size(), output)
+                != middle.size()
+                || !copyFileRange(input, oldEnd, oldBytes, output);
+        }
+        if (input != 0) {
+            fclose(input);
+        }
+        if (output != 0) {
+            failed = (fclose(output) != 0) || failed;
+        }
+        failed = failed || rename(temporary.c_str(), fName.c_str()) != 0;
+        how = "spliced";
+    } else {
+        FILE * output = fopen(fName.c_str(), "wb");
+        failed = (output == 0);
+        if (!failed) {
+            failed = fwrite(middle.data(), 1, middle.size(), output)
+                != middle.size();
+            failed = (fclose(output) != 0) || failed;
+        }
+        how = "rendered afresh";
+    }
+    if (failed || !writeManifest(fName, toneParameters, entries)) {
+        std::cout << "Unable to write " << fName << std::endl;
+        return 1;
+    }
+    renderStats.bytesWritten += middle.size();
+    std::cout << "Resynthesised " << (entries.size() - prefix - suffix)
+              << " of " << entries.size() << " glyphs, " << fName
+              << " " << how << "." << std::endl;
+    return 0;
+}
@@ -0,0 +1,63 @@
+// incrementalRender.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Re-renders an edited message by resynthesising only the glyphs
+//  which changed, using a manifest kept beside the audio file
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    incrementalRender.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef INCREMENTALRENDER_H
+#define INCREMENTALRENDER_H
+
+#include "bitmap2waterfall.h"
+
+// one glyph's place in the audio file, in samples. phase is the tone
+// phase at the glyph's first sample, which is always 0 as long as
+// generateAudio() restarts the tone for every glyph, but is recorded
+// so that a manifest says what it was written under
+struct ManifestEntry {
+    int codepoint;
+    uint64_t bitmapHash; // 0 if the font lacks the glyph
+    uint64_t offset;
+    uint64_t length;
+    int phase;
+};
+
+// the manifest lives beside the audio, as fName.manifest
+string manifestFileName(string fName);
+
+// for any other render to fName, which leaves the manifest stale
+void discardManifest(string fName);
+
+// As writeGlyphsToAudio(), but against the manifest left by the last
+// render to fName: the glyphs common to the start and end of both
+// messages are kept, and only those in between are synthesised. The
+// file is patched in place if the new middle is the same length as
+// the old one, and spliced into a new file otherwise. Without a
+// usable manifest the whole message is rendered, and a manifest made.
+int writeGlyphsToAudioIncremental(map<int, Glyph*> & glyphMap,
+                                  std::string_view glyphString,
+                                  int extraSpaces,
+                                  string fName,
+                                  GlyphAudioCache * cache = 0,
+                                  RenderContext * context = 0);
+
+#endif
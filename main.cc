@@ -33,47 +33,320 @@
 //    bitmap2waterfall.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
 //
 
-#include "bitmap2waterfall.cc"
+#include "bitmap2waterfall.h"
+#include "audioAtlas.h"
+#include "banner.h"
+#include "footprint.h"
+#include "hellDecoder.h"
+#include "waterfallImage.h"
+#include "fontSubset.h"
+#include "fontChain.h"
+#include "incrementalRender.h"
+#include "glyphChart.h"
+#include "beacon.h"
+#include "golden.h"
 #include <map>
 #include <iostream>
 #include <string>
+#include <csignal>
 
 using namespace std;
 
+// prints the run's stats, if asked for, whichever way main returns
+struct StatsReport {
+    ~StatsReport() {
+        if (renderStats.enabled) {
+            renderStats.printJSON(stderr);
+        }
+    }
+};
+
 int main (int argc, char * argv[]) {
 
-    string textToParse;
+    string textToParse = "";
     vector<int> glyphsToRender;
     int interSymbol32 = 0; // flag to add spacing, or not, between chars
-    if (argc > 1) {
-        textToParse = argv[1];
-    } else {
-        textToParse = "";
-    }
 
-    //    string defaultBDF = "fireflyR16.bdf";
+    // fonts are tried in order, i.e. for firefly with unifont as the
+    // fallback: --font fireflyR16.bdf --font unifont-8.0.01.bdf
     string defaultBDF = "unifont-8.0.01.bdf";
+    vector<string> fontFiles(1, defaultBDF);
+    int fontGiven = 0;
 
     string filename =  "output.raw";
+    string atlasToBuild = "";
+    string atlasToUse = "";
+    int outputGiven = 0;
+    int incremental = 0;
+    long repeatCount = -1; // -1 for no beacon, 0 for forever
+    char bannerDir = 0; // 0 for audio rather than a banner
+    int bannerWidth = 80;
+    BannerStyle bannerStyle = bannerAscii;
+    string subsetCorpus = "";
+    string waterfallAudio = "";
+    int verifyMode = 0;
+    int chartMode = 0;
+    string goldenCorpus = "";
+    int updateGolden = 0;
+    RenderBudget budget = {-1, -1, -1, -1, -1};
+    int chartPlane = 0;
+    string audioToDecode = "";
+    int decodeRows = 18; // unifont's 16 rows, plus 2 for the descent
+    int decodeChannels = 16;
+    int footprintMode = 0;
+    string footprintRange = "";
+    FootprintOptions footprintOptions;
+    footprintOptions.pixelPitch = 1000; // 10 mil
+    footprintOptions.pads = false;
     int outputRawIntegersToScreen = 0;
     int extraSpacesBetweenGlyphs = 0;
 
+    for (int arg = 1; arg < argc; arg++) {
+        string option = argv[arg];
+        if (option == "--build-atlas" && (arg + 1) < argc) {
+            atlasToBuild = argv[++arg];
+        } else if (option == "--atlas" && (arg + 1) < argc) {
+            atlasToUse = argv[++arg];
+        } else if (option == "--repeat" && (arg + 1) < argc) {
+            // only an explicit 0 means forever
+            char * end;
+            repeatCount = std::strtol(argv[++arg], &end, 10);
+            if (end == argv[arg] || *end != 0 || repeatCount < 0) {
+                std::cout << "--repeat takes a count, or 0 for forever, not "
+                          << argv[arg] << std::endl;
+                return 1;
+            }
+        } else if (option == "--incremental") {
+            incremental = 1;
+        } else if (option == "--stats") {
+            renderStats.enabled = true;
+        } else if (option == "--banner" && (arg + 1) < argc) {
+            bannerDir = argv[++arg][0];
+            if (string("UDLR").find(argv[arg]) == string::npos
+                || strlen(argv[arg]) != 1) {
+                std::cout << "--banner takes U, D, L or R, not "
+                          << argv[arg] << std::endl;
+                return 1;
+            }
+        } else if (option == "--width" && (arg + 1) < argc) {
+            bannerWidth = std::atoi(argv[++arg]);
+        } else if (option == "--blocks") {
+            bannerStyle = bannerBlocks;
+        } else if (option == "--font" && (arg + 1) < argc) {
+            if (!fontGiven) {
+                fontFiles.clear();
+                fontGiven = 1;
+            }
+            fontFiles.push_back(argv[++arg]);
+        } else if (option == "--subset" && (arg + 1) < argc) {
+            subsetCorpus = argv[++arg];
+        } else if (option == "--waterfall" && (arg + 1) < argc) {
+            waterfallAudio = argv[++arg];
+        } else if (option == "--golden" && (arg + 1) < argc) {
+            goldenCorpus = argv[++arg];
+        } else if (option == "--update-golden") {
+            updateGolden = 1;
+        } else if (option == "--budget" && (arg + 1) < argc) {
+            if (!parseRenderBudget(argv[++arg], budget)) {
+                std::cout << "Unknown budget: " << argv[arg] << std::endl;
+                return 1;
+            }
+        } else if (option == "--chart") {
+            chartMode = 1;
+        } else if (option == "--plane" && (arg + 1) < argc) {
+            chartPlane = std::atoi(argv[++arg]);
+        } else if (option == "--verify") {
+            verifyMode = 1;
+        } else if (option == "--decode" && (arg + 1) < argc) {
+            audioToDecode = argv[++arg];
+        } else if (option == "--rows" && (arg + 1) < argc) {
+            decodeRows = std::atoi(argv[++arg]);
+            if (decodeRows <= 0) {
+                std::cout << "--rows must be at least 1, not "
+                          << argv[arg] << std::endl;
+                return 1;
+            }
+        } else if (option == "--channels" && (arg + 1) < argc) {
+            decodeChannels = std::atoi(argv[++arg]);
+            if (decodeChannels < 1 || decodeChannels > 64) {
+                std::cout << "--channels must be from 1 to 64, not "
+                          << argv[arg] << std::endl;
+                return 1;
+            }
+        } else if (option == "--footprint") {
+            footprintMode = 1;
+        } else if (option == "--footprints" && (arg + 1) < argc) {
+            footprintRange = argv[++arg];
+        } else if (option == "--pitch" && (arg + 1) < argc) {
+            footprintOptions.pixelPitch = std::atoi(argv[++arg])*100;
+        } else if (option == "--pads") {
+            footprintOptions.pads = true;
+        } else if (option == "-o" && (arg + 1) < argc) {
+            filename = argv[++arg];
+            outputGiven = 1;
+        } else {
+            textToParse = option;
+        }
+    }
+
+    StatsReport statsReport;
+
+    if (atlasToBuild.length() != 0) {
+        FontChain fonts(fontFiles);
+        int result = buildAudioAtlas(fonts.allGlyphs(), atlasToBuild);
+        return result;
+    }
+
+    if (subsetCorpus.length() != 0) {
+        int result = writeFontSubset(subsetCorpus, fontFiles,
+                                     outputGiven ? filename : "subset.bdf");
+        return result;
+    }
+
+    if (waterfallAudio.length() != 0) {
+        int result = writeWaterfallImage(waterfallAudio, decodeChannels,
+                                         outputGiven ? filename
+                                         : "waterfall.pgm");
+        return result;
+    }
+
+    if (goldenCorpus.length() != 0) {
+        FontChain fonts(fontFiles);
+        int result = checkGoldenCorpus(fonts, goldenCorpus,
+                                       outputGiven ? filename
+                                       : goldenCorpus + ".golden",
+                                       updateGolden, budget);
+        return result;
+    }
+
+    if (chartMode) {
+        FontChain fonts(fontFiles);
+        int result = writeGlyphChart(fonts.allGlyphs(), chartPlane,
+                                     outputGiven ? filename : "chart.pgm");
+        return result;
+    }
+
+    if (audioToDecode.length() != 0) {
+        return decodeAudioFile(audioToDecode, decodeRows, decodeChannels);
+    }
+
+    if (verifyMode) {
+        // every glyph in the fonts, unless given some text
+        FontChain fonts(fontFiles);
+        int result = verifyGlyphAudio(textToParse.length()
+                                      ? fonts.glyphsFor(textToParse)
+                                      : fonts.allGlyphs(),
+                                      stringToGlyphCodeVector(textToParse,
+                                                              0));
+        return result;
+    }
+
+    if (footprintRange.length() != 0) {
+        // a range of hex codepoints, i.e. 2600-26FF
+        int first = std::strtol(footprintRange.c_str(), 0, 16);
+        size_t dash = footprintRange.find('-');
+        int last = (dash == string::npos) ? first
+            : std::strtol(footprintRange.c_str() + dash + 1, 0, 16);
+        FontChain fonts(fontFiles);
+        int result = writeFootprintLibrary(fonts.allGlyphs(), first, last,
+                                           outputGiven ? filename : ".",
+                                           footprintOptions);
+        return result;
+    }
+
+    if (footprintMode && textToParse.length() != 0) {
+        FontChain fonts(fontFiles);
+        string footprint = textFootprint(fonts.glyphsFor(textToParse),
+                                         textToParse, footprintOptions);
+        int result = writeBanner(footprint, outputGiven ? filename : "");
+        return result;
+    }
+
+    if (bannerDir != 0 && textToParse.length() != 0) {
+        FontChain fonts(fontFiles);
+        string banner;
+        renderBanner(fonts.glyphsFor(textToParse), textToParse, bannerDir,
+                     bannerWidth, bannerStyle, banner);
+        int result = writeBanner(banner, outputGiven ? filename : "");
+        return result;
+    }
+
+    if (repeatCount >= 0 && textToParse.length() != 0) {
+        // rendered once, then written from the same buffer each time
+        FontChain fonts(fontFiles);
+        GlyphAudioCache audioCache;
+        std::vector<int8_t> beacon;
+        if (filename != "-") {
+            discardManifest(filename);
+        }
+        signal(SIGPIPE, SIG_IGN); // a closed pipe shows up as EPIPE instead
+        int result = renderBeacon(fonts.glyphsFor(textToParse), textToParse,
+                                  extraSpacesBetweenGlyphs, &audioCache,
+                                  beacon)
+            || streamBeacon(beacon, repeatCount, filename);
+        return result;
+    }
+
     if (textToParse.length() != 0) {
-        // std::cout << "about to load: " << defaultBDF << endl;
-        std::map<int, Glyph*> glyphMap = load_bdf_file(defaultBDF);
-        // std::cout << "loaded: " << defaultBDF  << endl;
-        // std::cout << " glyph map size : "
-        // << glyphMap.size() << std::endl;
-        writeGlyphsToAudio(glyphMap,
-                           textToParse,
-                           extraSpacesBetweenGlyphs,                   
-                           filename,
-                           outputRawIntegersToScreen);
-        // time to clean up after ourselves
-        cleanUpGlyphMap(glyphMap);
+        if (atlasToUse.length() != 0) {
+            // no font needed, messages are assembled from the atlas
+            AudioAtlas atlas;
+            Glyph defaults((std::list<std::string>()));
+            bool opened;
+            {
+                StageTimer timer(renderStats.loadSeconds);
+                opened = atlas.open(atlasToUse);
+            }
+            if (!opened) {
+                return 1;
+            }
+            if (!atlas.matches(defaults)) {
+                std::cout << "Atlas " << atlasToUse
+                          << " was built with different tone parameters."
+                          << std::endl;
+                return 1;
+            }
+            discardManifest(filename);
+            if (writeAtlasGlyphsToAudio(atlas,
+                                        textToParse,
+                                        extraSpacesBetweenGlyphs,
+                                        filename)) {
+                return 1;
+            }
+        } else {
+            // fallback fonts are only loaded if the text needs them
+            FontChain fonts(fontFiles);
+            std::map<int, Glyph*> & glyphMap = fonts.glyphsFor(textToParse);
+            // std::cout << " glyph map size : "
+            // << glyphMap.size() << std::endl;
+            GlyphAudioCache audioCache;
+            if (incremental) {
+                // only the glyphs edited since the last render
+                if (writeGlyphsToAudioIncremental(glyphMap,
+                                                  textToParse,
+                                                  extraSpacesBetweenGlyphs,
+                                                  filename,
+                                                  &audioCache)) {
+                    return 1;
+                }
+            } else {
+                discardManifest(filename);
+                writeGlyphsToAudio(glyphMap,
+                                   textToParse,
+                                   extraSpacesBetweenGlyphs,
+                                   filename,
+                                   outputRawIntegersToScreen,
+                                   &audioCache);
+            }
+            if (VERBOSE) {
+                std::cout << "glyph audio cache hits: " << audioCache.hits
+                          << ", misses: " << audioCache.misses << std::endl;
+            }
+            // the font chain cleans up after itself
+        }
         std::cout << "Now use: \n"
                   << "sox -r 8000 -t raw -b 8 -e signed-integer "
-                  << "output" << ".raw "
+                  << filename << " "
                   << "output" << ".wav && play output.wav"
                   << std::endl;
     }
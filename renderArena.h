@@ -0,0 +1,125 @@
+// renderArena.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  A bump allocator for the scratch and output buffers used while
+//  rendering, so that once warmed up a render makes no heap
+//  allocations at all.
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    renderArena.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef RENDERARENA_H
+#define RENDERARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "renderStats.h"
+
+// allocations are carved off the current block, and are all given
+// back at once by reset(); if a render outgrows the block, further
+// blocks are chained on, and reset() then replaces the lot with a
+// single block big enough for the next render to fit in one go
+class RenderArena {
+public:
+
+    RenderArena(size_t initialBytes = 64*1024) {
+        blocks.reserve(8);
+        addBlock(initialBytes);
+        heapAllocations = 1;
+    }
+
+    ~RenderArena() {
+        releaseBlocks();
+    }
+
+    template <class T>
+    T * allocate(size_t count) {
+        size_t bytes = count*sizeof(T);
+        size_t start = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        if (start + bytes > blocks.back().size) {
+            size_t grown = blocks.back().size*2;
+            addBlock(grown > bytes ? grown : bytes);
+            start = 0;
+        }
+        used = start + bytes;
+        return (T*)(blocks.back().memory + start);
+    }
+
+    void reset() {
+        if (blocks.size() > 1) {
+            size_t total = 0;
+            for (size_t block = 0; block < blocks.size(); block++) {
+                total += blocks[block].size;
+            }
+            releaseBlocks();
+            addBlock(total);
+        }
+        used = 0;
+    }
+
+    // the number of times the arena itself has gone to the heap
+    unsigned long heapAllocations;
+
+private:
+
+    struct Block {
+        char * memory;
+        size_t size;
+    };
+
+    void addBlock(size_t bytes) {
+        Block block;
+        block.memory = (char*)malloc(bytes);
+        if (block.memory == 0) {
+            throw std::bad_alloc();
+        }
+        block.size = bytes;
+        blocks.push_back(block);
+        used = 0;
+        heapAllocations++;
+    }
+
+    void releaseBlocks() {
+        for (size_t block = 0; block < blocks.size(); block++) {
+            free(blocks[block].memory);
+        }
+        blocks.clear();
+    }
+
+    std::vector<Block> blocks;
+    size_t used;
+
+    RenderArena(const RenderArena &);
+    RenderArena & operator=(const RenderArena &);
+};
+
+// per render state which can be reused from one message to the next;
+// its counters go to the run's renderStats unless given others
+struct RenderContext {
+    RenderContext() : stats(&renderStats) {
+    }
+
+    RenderArena arena;
+    RenderStats * stats;
+};
+
+#endif
@@ -0,0 +1,51 @@
+// renderStats.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Stage timings and counters for a run, printed as JSON on
+//  request (--stats). Counters are cheap enough to always keep;
+//  the clock is only read when stats have been enabled.
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    renderStats.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "renderStats.h"
+#include <sys/resource.h>
+
+long peakRssKB() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // kB on linux
+}
+
+void RenderStats::printJSON(FILE * stream) const {
+    fprintf(stream,
+            "{\"stages_ms\":{\"load\":%.3f,\"tokenize\":%.3f,"
+            "\"synthesis\":%.3f,\"write\":%.3f},"
+            "\"glyphs_rendered\":%lu,\"missing_glyphs\":%lu,"
+            "\"cache_hits\":%lu,\"cache_misses\":%lu,"
+            "\"samples\":%llu,\"bytes_written\":%llu,"
+            "\"peak_rss_kb\":%ld}\n",
+            loadSeconds*1000, tokenizeSeconds*1000,
+            synthesisSeconds*1000, writeSeconds*1000,
+            glyphsRendered, missingGlyphs, cacheHits, cacheMisses,
+            samplesProduced, bytesWritten, peakRssKB());
+}
+
+RenderStats renderStats = {false, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
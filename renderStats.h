@@ -0,0 +1,86 @@
+// renderStats.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Stage timings and counters for a run, printed as JSON on
+//  request (--stats). Counters are cheap enough to always keep;
+//  the clock is only read when stats have been enabled.
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    renderStats.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <chrono>
+#include <cstdio>
+
+// peak resident set size of the process so far
+long peakRssKB();
+
+struct RenderStats {
+    bool enabled;
+
+    // seconds spent in each stage
+    double loadSeconds;
+    double tokenizeSeconds;
+    double synthesisSeconds;
+    double writeSeconds;
+
+    unsigned long glyphsRendered;
+    unsigned long missingGlyphs;
+    unsigned long cacheHits;
+    unsigned long cacheMisses;
+    unsigned long long samplesProduced;
+    unsigned long long bytesWritten;
+
+    void printJSON(FILE * stream) const;
+};
+
+extern RenderStats renderStats;
+
+// adds the time between construction and destruction to a stage,
+// but only if stats are enabled and the timer wanted, so costs a flag
+// test otherwise
+class StageTimer {
+public:
+
+    StageTimer(double & stageSeconds, bool wanted = true)
+        : seconds(stageSeconds) {
+        running = wanted && renderStats.enabled;
+        if (running) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~StageTimer() {
+        if (running) {
+            seconds += std::chrono::duration<double>
+                (std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+private:
+
+    double & seconds;
+    bool running;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
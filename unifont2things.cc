@@ -0,0 +1,234 @@
+// unifont2things.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  libunifont2things, the C++ and C interfaces over the font chain,
+//  glyph audio cache and renderer used by main
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//    unifont2things.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "unifont2things.h"
+#include "bitmap2waterfall.h"
+#include "fontChain.h"
+#include <stdexcept>
+
+namespace unifont2things {
+
+// every counter a renderer keeps is its own, so that renderers on
+// different threads never touch the same memory; only the flag which
+// turns timing on is shared
+struct HellRenderer::State {
+
+    State(const std::vector<std::string> & fontFiles)
+        : stats(zeroedStats()), fonts(fontFiles, stats) {
+        context.stats = &stats;
+        cache.countInto(stats);
+    }
+
+    static RenderStats zeroedStats() {
+        RenderStats zeroed;
+        memset(&zeroed, 0, sizeof(zeroed));
+        return zeroed;
+    }
+
+    RenderStats stats;
+    FontChain fonts;
+    GlyphAudioCache cache;
+    RenderContext context;
+};
+
+HellRenderer::HellRenderer(const std::vector<std::string> & fontFiles) {
+    if (fontFiles.empty()) {
+        throw std::runtime_error("no font files given");
+    }
+    state.reset(new State(fontFiles));
+    // the primary font, up front, so a bad path is caught here
+    if (state->fonts.glyphsFor("").empty()) {
+        throw std::runtime_error("no glyphs in font " + fontFiles[0]);
+    }
+}
+
+HellRenderer::~HellRenderer() {
+}
+
+std::vector<int8_t> HellRenderer::render(std::string_view utf8) {
+    std::vector<int8_t> audio;
+    render(utf8, [&audio](const int8_t * samples, size_t count) {
+                     audio.insert(audio.end(), samples, samples + count);
+                 });
+    return audio;
+}
+
+size_t HellRenderer::render(std::string_view utf8,
+                            int8_t * buffer,
+                            size_t capacity) {
+    map<int, Glyph*> & glyphMap = state->fonts.glyphsFor(utf8);
+    if (buffer == 0) {
+        capacity = 0;
+    }
+    size_t total = 0;
+    Utf8Tokenizer tokens(utf8, 0, state->stats);
+    int codepoint;
+    while (tokens.next(codepoint)) {
+        if (total >= capacity) {
+            // only measuring from here on, which needs no synthesis
+            map<int, Glyph*>::iterator found = glyphMap.find(codepoint);
+            if (found == glyphMap.end() || found->second == 0) {
+                state->stats.missingGlyphs++;
+            } else {
+                total += found->second->audioLength();
+            }
+            continue;
+        }
+        size_t length;
+        const int8_t * audio = renderGlyphCodeAudio(glyphMap, codepoint,
+                                                    &state->cache,
+                                                    state->context, length);
+        if (audio != 0) {
+            StageTimer timer(state->stats.writeSeconds);
+            size_t copied = std::min(length, capacity - total);
+            memcpy(buffer + total, audio, copied);
+            state->stats.bytesWritten += copied;
+            total += length;
+        }
+    }
+    return total;
+}
+
+void HellRenderer::render(std::string_view utf8, const AudioSink & sink) {
+    map<int, Glyph*> & glyphMap = state->fonts.glyphsFor(utf8);
+    Utf8Tokenizer tokens(utf8, 0, state->stats);
+    int codepoint;
+    while (tokens.next(codepoint)) {
+        size_t length;
+        const int8_t * audio = renderGlyphCodeAudio(glyphMap, codepoint,
+                                                    &state->cache,
+                                                    state->context, length);
+        if (audio != 0) {
+            StageTimer timer(state->stats.writeSeconds);
+            sink(audio, length);
+            state->stats.bytesWritten += length;
+        }
+    }
+}
+
+u2t_stats HellRenderer::stats() const {
+    const RenderStats & counters = state->stats;
+    u2t_stats totals;
+    totals.load_ms = counters.loadSeconds*1000;
+    totals.synthesis_ms = counters.synthesisSeconds*1000;
+    totals.glyphs_rendered = counters.glyphsRendered;
+    totals.missing_glyphs = counters.missingGlyphs;
+    totals.cache_hits = counters.cacheHits;
+    totals.cache_misses = counters.cacheMisses;
+    totals.samples_produced = counters.samplesProduced;
+    totals.write_ms = counters.writeSeconds*1000;
+    totals.bytes_written = counters.bytesWritten;
+    return totals;
+}
+
+void HellRenderer::resetStats() {
+    state->stats = State::zeroedStats();
+}
+
+}
+
+using unifont2things::HellRenderer;
+
+// the C handle is just the C++ renderer, and no exception is allowed
+// to escape through the C interface
+struct u2t_renderer {
+    HellRenderer * renderer;
+};
+
+extern "C" {
+
+u2t_renderer * u2t_open(const char * const * font_files, int count) {
+    if (font_files == 0 || count <= 0) {
+        return 0;
+    }
+    try {
+        std::vector<std::string> fontFiles(font_files, font_files + count);
+        std::unique_ptr<HellRenderer> renderer(new HellRenderer(fontFiles));
+        u2t_renderer * handle = new u2t_renderer;
+        handle->renderer = renderer.release();
+        return handle;
+    } catch (...) {
+        return 0;
+    }
+}
+
+void u2t_close(u2t_renderer * renderer) {
+    if (renderer != 0) {
+        delete renderer->renderer;
+        delete renderer;
+    }
+}
+
+long u2t_render(u2t_renderer * renderer,
+                const char * utf8,
+                int8_t * buffer,
+                size_t capacity) {
+    if (renderer == 0 || utf8 == 0) {
+        return -1;
+    }
+    try {
+        return renderer->renderer->render(utf8, buffer, capacity);
+    } catch (...) {
+        return -1;
+    }
+}
+
+int u2t_render_cb(u2t_renderer * renderer,
+                  const char * utf8,
+                  u2t_audio_callback callback,
+                  void * user) {
+    if (renderer == 0 || utf8 == 0 || callback == 0) {
+        return -1;
+    }
+    try {
+        renderer->renderer->render(utf8,
+                                   [callback, user](const int8_t * samples,
+                                                    size_t count) {
+                                       callback(samples, count, user);
+                                   });
+        return 0;
+    } catch (...) {
+        return -1;
+    }
+}
+
+void u2t_get_stats(const u2t_renderer * renderer, u2t_stats * stats) {
+    if (renderer != 0 && stats != 0) {
+        *stats = renderer->renderer->stats();
+    }
+}
+
+void u2t_reset_stats(u2t_renderer * renderer) {
+    if (renderer != 0) {
+        renderer->renderer->resetStats();
+    }
+}
+
+void u2t_enable_timing(int enabled) {
+    renderStats.enabled = (enabled != 0);
+}
+
+}
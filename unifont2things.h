@@ -0,0 +1,147 @@
+// unifont2things.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  The public interface of libunifont2things, for programs which
+//  want Hellschreiber audio from gnu Unifont, or any other .bdf,
+//  .hex or .u2f font, without running the main utility
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//    unifont2things.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+// Audio is 8000 Hz signed 8 bit mono, in exactly the order main
+// writes it to a .raw file, so a message rendered through either
+// interface plays the same as one from the command line. Only the
+// declarations below are part of the interface; the other headers
+// are internal and may change from one release to the next.
+
+#ifndef UNIFONT2THINGS_H
+#define UNIFONT2THINGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define U2T_SAMPLE_RATE 8000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// an open chain of fonts, with its own glyph audio cache and stats;
+// separate renderers can be used on separate threads at once, but a
+// renderer must only be used by one thread at a time
+typedef struct u2t_renderer u2t_renderer;
+
+// counters for a renderer since it was opened, or since the last
+// u2t_reset_stats(); stage times are only kept once enabled. Writing
+// is copying into the caller's buffer, or handing audio to the
+// callback, so bytes_written is what the caller actually received.
+typedef struct u2t_stats {
+    double load_ms;
+    double synthesis_ms;
+    unsigned long glyphs_rendered;
+    unsigned long missing_glyphs;
+    unsigned long cache_hits;
+    unsigned long cache_misses;
+    unsigned long long samples_produced;
+    double write_ms;
+    unsigned long long bytes_written;
+} u2t_stats;
+
+// called with successive runs of a message's audio
+typedef void (*u2t_audio_callback)(const int8_t * samples,
+                                   size_t count,
+                                   void * user);
+
+// font_files are tried in order for each glyph, later ones only
+// being loaded if an earlier one lacks a glyph; NULL on failure
+u2t_renderer * u2t_open(const char * const * font_files, int count);
+
+void u2t_close(u2t_renderer * renderer);
+
+// renders UTF-8 text, with U+XXXX escapes, into buffer and returns
+// the number of samples in the whole message, writing only as many
+// as fit in capacity; a NULL buffer just measures the message.
+// Returns -1 on error.
+long u2t_render(u2t_renderer * renderer,
+                const char * utf8,
+                int8_t * buffer,
+                size_t capacity);
+
+// as u2t_render(), but hands the audio to callback a glyph at a time
+// without any buffer of the caller's; returns 0, or -1 on error
+int u2t_render_cb(u2t_renderer * renderer,
+                  const char * utf8,
+                  u2t_audio_callback callback,
+                  void * user);
+
+void u2t_get_stats(const u2t_renderer * renderer, u2t_stats * stats);
+
+void u2t_reset_stats(u2t_renderer * renderer);
+
+// stage timing costs a clock read per stage, so is off by default;
+// it applies to every renderer, so is best set before any rendering
+void u2t_enable_timing(int enabled);
+
+#ifdef __cplusplus
+}
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace unifont2things {
+
+// the C++ face of u2t_renderer; the constructor throws
+// std::runtime_error if no fonts are given or the first has no glyphs
+class HellRenderer {
+public:
+
+    typedef std::function<void(const int8_t *, size_t)> AudioSink;
+
+    explicit HellRenderer(const std::vector<std::string> & fontFiles);
+    ~HellRenderer();
+
+    HellRenderer(const HellRenderer &) = delete;
+    HellRenderer & operator=(const HellRenderer &) = delete;
+
+    // the whole message's audio
+    std::vector<int8_t> render(std::string_view utf8);
+
+    // samples in the whole message, of which at most capacity are
+    // written to buffer, which may be null
+    size_t render(std::string_view utf8, int8_t * buffer, size_t capacity);
+
+    void render(std::string_view utf8, const AudioSink & sink);
+
+    u2t_stats stats() const;
+    void resetStats();
+
+private:
+
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+// waterfallImage.cc v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Renders Hellschreiber audio as a waterfall, i.e. a spectrogram
+//  with the newest audio at the top as fldigi shows it, into a
+//  grayscale PGM or PNG image, along with the image writers
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    waterfallImage.cc (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#include "waterfallImage.h"
+#include <complex>
+#include <thread>
+#include <cstdio>
+#include <zlib.h>
+
+static void appendBigEndian32(std::vector<uint8_t> & bytes, uint32_t value) {
+    bytes.push_back(value >> 24);
+    bytes.push_back(value >> 16);
+    bytes.push_back(value >> 8);
+    bytes.push_back(value);
+}
+
+static void appendPngChunk(std::vector<uint8_t> & png,
+                           const char * type,
+                           const std::vector<uint8_t> & data) {
+    appendBigEndian32(png, data.size());
+    size_t typeStart = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, &png[typeStart], png.size() - typeStart);
+    appendBigEndian32(png, crc);
+}
+
+int writeGrayImage(string fName,
+                   const std::vector<uint8_t> & pixels,
+                   int width,
+                   int height) {
+    std::vector<uint8_t> encoded;
+    bool png = fName.length() > 4
+        && fName.compare(fName.length() - 4, 4, ".png") == 0;
+    if (png) {
+        static const uint8_t signature[8] =
+            {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        encoded.assign(signature, signature + 8);
+        std::vector<uint8_t> header;
+        appendBigEndian32(header, width);
+        appendBigEndian32(header, height);
+        header.push_back(8); // bit depth
+        header.push_back(0); // grayscale
+        header.push_back(0); // deflate
+        header.push_back(0); // adaptive filtering
+        header.push_back(0); // not interlaced
+        appendPngChunk(encoded, "IHDR", header);
+        // each row is prefixed with filter type 0, i.e. none
+        std::vector<uint8_t> filtered((size_t)(width + 1)*height);
+        for (int row = 0; row < height; row++) {
+            filtered[(size_t)row*(width + 1)] = 0;
+            memcpy(&filtered[(size_t)row*(width + 1) + 1],
+                   &pixels[(size_t)row*width], width);
+        }
+        uLongf deflatedBytes = compressBound(filtered.size());
+        std::vector<uint8_t> deflated(deflatedBytes);
+        if (compress2(deflated.data(), &deflatedBytes,
+                      filtered.data(), filtered.size(),
+                      Z_BEST_SPEED) != Z_OK) {
+            std::cout << "Unable to compress image: " << fName << std::endl;
+            return 1;
+        }
+        deflated.resize(deflatedBytes);
+        appendPngChunk(encoded, "IDAT", deflated);
+        appendPngChunk(encoded, "IEND", std::vector<uint8_t>());
+    } else {
+        char header[64];
+        int headerBytes = snprintf(header, sizeof(header),
+                                   "P5\n%d %d\n255\n", width, height);
+        encoded.assign(header, header + headerBytes);
+        encoded.insert(encoded.end(), pixels.begin(), pixels.end());
+    }
+    FILE * fOutput = fopen(fName.c_str(), "wb");
+    if (fOutput == 0) {
+        std::cout << "Unable to open image file: " << fName << std::endl;
+        return 1;
+    }
+    bool failed = fwrite(encoded.data(), 1, encoded.size(), fOutput)
+        != encoded.size();
+    failed = (fclose(fOutput) != 0) || failed;
+    renderStats.bytesWritten += encoded.size();
+    return failed ? 1 : 0;
+}
+
+// iterative radix 2 FFT of a fixed power of two size
+class FFT {
+public:
+
+    FFT(int size) {
+        n = size;
+        int bits = 0;
+        while ((1 << bits) < n) {
+            bits++;
+        }
+        reversed.resize(n);
+        for (int index = 0; index < n; index++) {
+            int flipped = 0;
+            for (int bit = 0; bit < bits; bit++) {
+                if (index & (1 << bit)) {
+                    flipped |= 1 << (bits - 1 - bit);
+                }
+            }
+            reversed[index] = flipped;
+        }
+        twiddles.resize(n/2);
+        for (int index = 0; index < n/2; index++) {
+            twiddles[index] = std::polar(1.0f, (float)(-2*M_PI*index/n));
+        }
+    }
+
+    void transform(std::vector<std::complex<float> > & data) const {
+        for (int index = 0; index < n; index++) {
+            if (index < reversed[index]) {
+                std::swap(data[index], data[reversed[index]]);
+            }
+        }
+        for (int span = 2; span <= n; span <<= 1) {
+            int half = span/2;
+            int stride = n/span;
+            for (int start = 0; start < n; start += span) {
+                for (int offset = 0; offset < half; offset++) {
+                    std::complex<float> odd =
+                        data[start + offset + half]*twiddles[offset*stride];
+                    data[start + offset + half] = data[start + offset] - odd;
+                    data[start + offset] += odd;
+                }
+            }
+        }
+    }
+
+private:
+
+    int n;
+    std::vector<int> reversed;
+    std::vector<std::complex<float> > twiddles;
+};
+
+// Hann windowed STFT frames every hopSamples, zero padded to fftSize
+// for finer bins, covering the Hell tone channels plus a couple of
+// channels' margin either side. Each thread takes a contiguous run
+// of frames and writes straight into its rows of the image; levels
+// are then scaled over the top dynamicRangeDB of the image.
+int renderWaterfallImage(const std::vector<int8_t> & audio,
+                         const Glyph & toneSource,
+                         int channels,
+                         string fName) {
+    const int windowSize = 2048;
+    const int fftSize = 4096;
+    const int hopSamples = 200;
+    const float dynamicRangeDB = 60;
+    double binHz = (double)toneSource.bitRate/fftSize;
+    double lowHz = toneSource.floorFreq - 2*toneSource.freqSpacing;
+    double highHz = toneSource.floorFreq
+        + (channels + 1)*toneSource.freqSpacing;
+    int firstBin = (lowHz > 0) ? (int)(lowHz/binHz) : 0;
+    int lastBin = (int)(highHz/binHz);
+    if (lastBin >= fftSize/2) {
+        lastBin = fftSize/2 - 1;
+    }
+    int width = lastBin - firstBin + 1;
+    int frames = (audio.size() > windowSize)
+        ? 1 + (audio.size() - windowSize)/hopSamples : 1;
+    int height = frames;
+
+    std::vector<float> window(windowSize);
+    for (int index = 0; index < windowSize; index++) {
+        window[index] = 0.5 - 0.5*cos(2*M_PI*index/(windowSize - 1));
+    }
+    FFT fft(fftSize);
+    std::vector<float> levels((size_t)width*height);
+
+    int threadCount = std::thread::hardware_concurrency();
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    std::vector<float> threadPeaks(threadCount, -1000);
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers.push_back(std::thread([&, thread]() {
+            std::vector<std::complex<float> > buffer(fftSize);
+            int first = (long)frames*thread/threadCount;
+            int last = (long)frames*(thread + 1)/threadCount;
+            // two real frames go through each complex FFT, one as
+            // the real part and one as the imaginary part, and are
+            // separated again using the conjugate symmetry of each
+            for (int frame = first; frame < last; frame += 2) {
+                bool paired = (frame + 1) < last;
+                size_t start = (size_t)frame*hopSamples;
+                for (int index = 0; index < fftSize; index++) {
+                    float real = 0;
+                    float imaginary = 0;
+                    if (index < windowSize) {
+                        if (start + index < audio.size()) {
+                            real = audio[start + index]*window[index];
+                        }
+                        if (paired && start + hopSamples + index
+                            < audio.size()) {
+                            imaginary = audio[start + hopSamples + index]
+                                *window[index];
+                        }
+                    }
+                    buffer[index] = std::complex<float>(real, imaginary);
+                }
+                fft.transform(buffer);
+                // newest audio at the top, as on a waterfall
+                float * row = &levels[(size_t)(frames - 1 - frame)*width];
+                float * nextRow = paired
+                    ? &levels[(size_t)(frames - 2 - frame)*width] : 0;
+                for (int bin = firstBin; bin <= lastBin; bin++) {
+                    std::complex<float> mirror =
+                        std::conj(buffer[(fftSize - bin) % fftSize]);
+                    float level =
+                        10*log10f(std::norm(0.5f*(buffer[bin] + mirror))
+                                  + 1e-3f);
+                    row[bin - firstBin] = level;
+                    if (level > threadPeaks[thread]) {
+                        threadPeaks[thread] = level;
+                    }
+                    if (paired) {
+                        level =
+                            10*log10f(std::norm(0.5f*(buffer[bin] - mirror))
+                                      + 1e-3f);
+                        nextRow[bin - firstBin] = level;
+                        if (level > threadPeaks[thread]) {
+                            threadPeaks[thread] = level;
+                        }
+                    }
+                }
+            }
+        }));
+    }
+    for (int thread = 0; thread < threadCount; thread++) {
+        workers[thread].join();
+    }
+    float peak = *std::max_element(threadPeaks.begin(), threadPeaks.end());
+    std::vector<uint8_t> pixels(levels.size());
+    for (size_t index = 0; index < levels.size(); index++) {
+        float scaled = (levels[index] - (peak - dynamicRangeDB))
+            *255/dynamicRangeDB;
+        pixels[index] = (scaled < 0) ? 0 : (scaled > 255) ? 255 : scaled;
+    }
+    return writeGrayImage(fName, pixels, width, height);
+}
+
+int writeWaterfallImage(string audioFile, int channels, string fName) {
+    std::vector<int8_t> audio;
+    {
+        StageTimer timer(renderStats.loadSeconds);
+        std::ifstream input(audioFile.c_str(), std::ios::binary);
+        if (!input) {
+            std::cout << "Unable to open audio file: " << audioFile << std::endl;
+            return 1;
+        }
+        input.seekg(0, std::ios::end);
+        audio.resize(input.tellg());
+        input.seekg(0, std::ios::beg);
+        input.read((char*)audio.data(), audio.size());
+    }
+    Glyph defaults((std::list<std::string>()));
+    StageTimer timer(renderStats.synthesisSeconds);
+    return renderWaterfallImage(audio, defaults, channels, fName);
+}
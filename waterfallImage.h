@@ -0,0 +1,49 @@
+// waterfallImage.h v1.0
+// Copyright (C) 2016 Erich S. Heinzle, a1039181@gmail.com
+//
+//  Renders Hellschreiber audio as a waterfall, i.e. a spectrogram
+//  with the newest audio at the top as fldigi shows it, into a
+//  grayscale PGM or PNG image, along with the image writers
+//
+//    see LICENSE-gpl-v2.txt for software license
+//    see README.txt
+//    
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 2
+//    of the License, or (at your option) any later version.
+//    
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//    
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//    
+//    waterfallImage.h (C) 2016 Erich S. Heinzle a1039181@gmail.com
+//
+
+#ifndef WATERFALLIMAGE_H
+#define WATERFALLIMAGE_H
+
+#include "bitmap2waterfall.h"
+
+// an 8 bit grayscale image, as PNG if the file name ends in .png,
+// otherwise as binary PGM
+int writeGrayImage(string fName,
+                   const std::vector<uint8_t> & pixels,
+                   int width,
+                   int height);
+
+// the audio as fldigi's waterfall would show it, newest at the top,
+// across channels tone channels, written as by writeGrayImage()
+int renderWaterfallImage(const std::vector<int8_t> & audio,
+                         const Glyph & toneSource,
+                         int channels,
+                         string fName);
+
+int writeWaterfallImage(string audioFile, int channels, string fName);
+
+#endif